@@ -0,0 +1,188 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../headers/ppu_decode.hpp"
+#include "../headers/pacing.hpp"
+
+// Times the tile row decoders against the per-pixel bit loop they replaced,
+// after checking every one of them on all 65536 plane pairs.
+//
+//   decode_bench           check, then time (build with CMAKE_BUILD_TYPE=Release)
+//   decode_bench --check   check only (the ctest target)
+
+#define PAIRS 0x10000
+
+// Tiles of random data each timed pass decodes, 64 KB like a VRAM's worth
+#define BENCH_TILES 4096
+#define BENCH_PASSES 2000
+
+// The bit loop the tile cache used before ppu_decode.cpp
+static void bitloop_rows(const u8 *data, u32 rows, u8 *out, u8 *flipped) {
+    for (u32 row = 0; row < rows; row++) {
+        u8 lo = data[row * 2];
+        u8 hi = data[(row * 2) + 1];
+
+        for (int x = 0; x < 8; x++) {
+            int bit = 7 - x;
+            u8 color = ((lo >> bit) & 1) | (((hi >> bit) & 1) << 1);
+
+            out[(row * 8) + x] = color;
+            flipped[(row * 8) + 7 - x] = color;
+        }
+    }
+}
+
+static u8 pairs[PAIRS * 2];
+static u8 expect[PAIRS * 8];
+static u8 expect_flipped[PAIRS * 8];
+static u8 out[PAIRS * 8];
+static u8 out_flipped[PAIRS * 8];
+
+static bool check_output(const char *name, u32 rows) {
+    for (u32 r = 0; r < rows; r++) {
+        if (memcmp(out + (r * 8), expect + (r * 8), 8) ||
+                memcmp(out_flipped + (r * 8), expect_flipped + (r * 8), 8)) {
+            printf("%s: wrong row for lo %02X hi %02X\n", name, pairs[r * 2], pairs[(r * 2) + 1]);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Every lo/hi pair, in one call and in calls of 1 - 7 rows for the tails
+static bool check_kernel(const ppu_decode_impl *k) {
+    memset(out, 0xAA, sizeof(out));
+    memset(out_flipped, 0xAA, sizeof(out_flipped));
+    k->fn(pairs, PAIRS, out, out_flipped);
+
+    if (!check_output(k->name, PAIRS)) {
+        return false;
+    }
+
+    memset(out, 0xAA, sizeof(out));
+    memset(out_flipped, 0xAA, sizeof(out_flipped));
+
+    for (u32 r = 0, n = 1; r < PAIRS; r += n, n = (n % 7) + 1) {
+        u32 rows = r + n <= PAIRS ? n : PAIRS - r;
+        k->fn(pairs + (r * 2), rows, out + (r * 8), out_flipped + (r * 8));
+    }
+
+    return check_output(k->name, PAIRS);
+}
+
+static bool check_all(const ppu_decode_impl *kernels, u32 count) {
+    for (u32 i = 0; i < PAIRS; i++) {
+        pairs[i * 2] = i & 0xFF;
+        pairs[(i * 2) + 1] = i >> 8;
+    }
+
+    bitloop_rows(pairs, PAIRS, expect, expect_flipped);
+
+    // ppu_decode_row(), the single-row path the FIFO uses
+    for (u32 i = 0; i < PAIRS; i++) {
+        ppu_decode_row(pairs[i * 2], pairs[(i * 2) + 1], out + (i * 8));
+        ppu_decode_row(ppu_decode_lut.reverse[pairs[i * 2]],
+            ppu_decode_lut.reverse[pairs[(i * 2) + 1]], out_flipped + (i * 8));
+    }
+
+    if (!check_output("table", PAIRS)) {
+        return false;
+    }
+
+    for (u32 i = 0; i < count; i++) {
+        if (!check_kernel(&kernels[i])) {
+            return false;
+        }
+    }
+
+    printf("All %u plane pairs match the bit loop: table", PAIRS);
+
+    for (u32 i = 0; i < count; i++) {
+        printf(", %s", kernels[i].name);
+    }
+
+    printf("\n");
+    return true;
+}
+
+static u8 tiles[BENCH_TILES * 16];
+static u8 tiles_out[BENCH_TILES * 64];
+static u8 tiles_flipped[BENCH_TILES * 64];
+
+// Keeps the decoded pixels alive so the passes aren't optimized away
+static volatile u8 sink;
+
+// ns per 8-row tile, normal and mirrored
+static double bench_tiles(ppu_decode_fn fn) {
+    u64 start = pacing_now_ns();
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (u32 t = 0; t < BENCH_TILES; t++) {
+            fn(tiles + (t * 16), 8, tiles_out + (t * 64), tiles_flipped + (t * 64));
+        }
+
+        sink = tiles_out[pass % sizeof(tiles_out)] ^ tiles_flipped[pass % sizeof(tiles_flipped)];
+    }
+
+    return (double)(pacing_now_ns() - start) / ((double)BENCH_PASSES * BENCH_TILES);
+}
+
+// ns per single row, not mirrored, like a FIFO fetch
+static double bench_row(bool table) {
+    u8 unused[8];
+    u64 start = pacing_now_ns();
+
+    for (int pass = 0; pass < BENCH_PASSES; pass++) {
+        for (u32 r = 0; r < BENCH_TILES * 8; r++) {
+            u8 *row = tiles_out + (r * 8);
+
+            if (table) {
+                ppu_decode_row(tiles[r * 2], tiles[(r * 2) + 1], row);
+            } else {
+                bitloop_rows(tiles + (r * 2), 1, row, unused);
+            }
+        }
+
+        sink = tiles_out[pass % sizeof(tiles_out)];
+    }
+
+    return (double)(pacing_now_ns() - start) / ((double)BENCH_PASSES * BENCH_TILES * 8);
+}
+
+int main(int argc, char **argv) {
+    bool check_only = argc > 1 && !strcmp(argv[1], "--check");
+    u32 count;
+    const ppu_decode_impl *kernels = ppu_decode_kernels(&count);
+
+    if (!check_all(kernels, count)) {
+        return 1;
+    }
+
+    if (check_only) {
+        return 0;
+    }
+
+    // xorshift32, the same tiles on every run
+    u32 x = 0x12345678;
+
+    for (u32 i = 0; i < sizeof(tiles); i++) {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        tiles[i] = x;
+    }
+
+    printf("Per 8-row tile, normal and mirrored (ppu_decode_rows() uses %s):\n", ppu_decode_kernel());
+    printf("  %-8s %7.2f ns\n", "bit loop", bench_tiles(bitloop_rows));
+
+    for (u32 i = 0; i < count; i++) {
+        printf("  %-8s %7.2f ns\n", kernels[i].name, bench_tiles(kernels[i].fn));
+    }
+
+    printf("Per row, normal only:\n");
+    printf("  %-8s %7.2f ns\n", "bit loop", bench_row(false));
+    printf("  %-8s %7.2f ns\n", "table", bench_row(true));
+
+    return 0;
+}
@@ -49,6 +49,9 @@ cart_context *cart_get_context();
 
 bool cart_load(char *cart);
 
+// Frees the ROM and RAM banks of the loaded cart
+void cart_unload();
+
 u8 cart_read(u16 address);
 void cart_write(u16 address, u8 value);
 
@@ -3,21 +3,46 @@
 #include <../headers/common.hpp>
 #include <../headers/instructions.hpp>
 
+// Register pairs overlay their two 8-bit halves, with the byte order picked
+// for the host so AF/BC/DE/HL are plain 16-bit loads and stores.
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define CPU_REG_PAIR(hi, lo) union { struct { u8 hi; u8 lo; }; u16 hi##lo; }
+#define CPU_REG_HI_BYTE 0
+#else
+#define CPU_REG_PAIR(hi, lo) union { struct { u8 lo; u8 hi; }; u16 hi##lo; }
+#define CPU_REG_HI_BYTE 1
+#endif
+
+typedef struct {
+    union {
+        struct {
+            CPU_REG_PAIR(a, f);
+            CPU_REG_PAIR(b, c);
+            CPU_REG_PAIR(d, e);
+            CPU_REG_PAIR(h, l);
+            u16 sp;
+            u16 pc;
+        };
+
+        u8 r8[12];      // Indexed by cpu_reg8_index()
+        u16 r16[6];     // Indexed by cpu_reg16_index()
+    };
+} cpu_regs;
+
+typedef struct _decoded_inst decoded_inst;
+
+// Operands of the last flag-setting ALU op, see cpu_flags.hpp
 typedef struct {
+    u8 op;          // lazy_flags_op, LF_NONE when regs.f is up to date
     u8 a;
-    u8 f;
     u8 b;
-    u8 c;
-    u8 d;
-    u8 e;
-    u8 h;
-    u8 l;
-    u16 pc;
-    u16 sp;
-} cpu_regs;
+    u8 carry;       // Carry in (ADC/SBC) or the carry kept by INC/DEC/BIT
+    u16 result;
+} cpu_lazy_flags;
 
 typedef struct {
     cpu_regs regs;
+    cpu_lazy_flags lazy;
 
     // current instantiation...
     
@@ -25,7 +50,8 @@ typedef struct {
     u16 mem_dest;
     bool dest_is_mem;
     u8 current_opcode;
-    instruction *current_inst;
+    const instruction *current_inst;
+    decoded_inst *decoded;      // Decode cache entry for the current instruction (if cached)
 
     bool halted;
     bool stepping;
@@ -39,17 +65,34 @@ typedef struct {
 
 cpu_regs *cpu_get_regs();
 
+typedef enum {
+    CORE_INTERP,
+    CORE_THREADED,
+    CORE_DYNAREC
+} cpu_core;
+
 void cpu_init();
 bool cpu_step();
 
+// Runs up to `steps` instructions on the selected core
+bool cpu_exec(u32 steps);
+
+void cpu_set_core(cpu_core core);
+cpu_core cpu_get_core();
+
 typedef void (*IN_PROC)(cpu_context *);
 
 IN_PROC inst_get_proc(in_type type);
 
-#define CPU_FLAG_Z BIT(ctx->regs.f, 7)
-#define CPU_FLAG_N BIT(ctx->regs.f, 6)
-#define CPU_FLAG_H BIT(ctx->regs.f, 5)
-#define CPU_FLAG_C BIT(ctx->regs.f, 4)
+// Handler specialized for the opcode: operand fetch, dbg_update() and execute
+IN_PROC cpu_op_handler(u8 opcode);
+
+// Handler for the CB-prefixed opcode `cb`, the prefix and `cb` already fetched
+IN_PROC cpu_cb_handler(u8 cb);
+
+// Slots of a register in cpu_regs.r8 / r16, reg_type order follows the layout
+#define cpu_reg8_index(rt) ((((rt) - RT_A) & ~1) | ((((rt) - RT_A) & 1) ^ CPU_REG_HI_BYTE))
+#define cpu_reg16_index(rt) ((rt) - RT_AF)
 
 u16 cpu_read_reg(reg_type rt);
 void cpu_set_reg(reg_type rt, u16 val);
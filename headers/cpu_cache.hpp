@@ -0,0 +1,29 @@
+#pragma once
+
+#include <../headers/common.hpp>
+#include <../headers/cpu.hpp>
+
+// Predecoded instruction, built the first time a PC is fetched
+struct _decoded_inst {
+    const instruction *inst;
+    IN_PROC proc;               // cpu_op_handler() for the opcode
+
+    u16 operand;        // Immediate bytes after the opcode (lo | hi << 8)
+    u8 opcode;
+    u8 length;          // Opcode + immediates, one M-cycle each to fetch
+
+    u8 bank;            // rom_bank_value the entry was decoded under (0x4000 - 0x7FFF)
+    bool valid;
+};
+
+typedef struct {
+    decoded_inst rom0[0x4000];      // 0x0000 - 0x3FFF
+    decoded_inst romx[0x4000];      // 0x4000 - 0x7FFF, tagged with the bank
+    decoded_inst wram[0x2000];      // 0xC000 - 0xDFFF
+    decoded_inst hram[0x7F];        // 0xFF80 - 0xFFFE
+} cpu_cache_context;
+
+void cpu_cache_init();
+
+decoded_inst *cpu_cache_lookup(u16 pc);
+void cpu_cache_invalidate(u16 address);
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <../headers/common.hpp>
+#include <../headers/cpu_cache.hpp>
+
+// Dynamic recompiler for code running from cartridge ROM (x86-64 hosts).
+
+// One translated instruction, what its handler call (slow paths and the
+// instructions without host code) needs
+typedef struct {
+    decoded_inst decoded;
+    u16 pc;
+    u16 next_pc;
+} jit_entry;
+
+typedef struct {
+    u8 *code;           // Host code, nullptr if not translated
+    u8 bank;
+    u8 count;           // Instructions
+} jit_block;
+
+typedef struct {
+    u8 *code;           // Bump allocated, read/execute except the block being written
+    u32 code_used;
+
+    jit_entry *entries;
+    u32 entries_used;
+
+    jit_block rom0[0x4000];
+    jit_block romx[0x4000];
+
+    bool exit_block;    // Set by a bank switch
+    bool check;         // A store the running block has to check (see jit_write())
+
+    bool disabled;      // mmap() or mprotect() failed, interpreter only
+} jit_context;
+
+// Runs exactly `steps` CPU steps, code outside ROM goes through cpu_step().
+bool cpu_dynarec_exec(u32 steps);
+
+// Called by the cartridge when rom_bank_x changes, ends the running block
+void cpu_dynarec_bank_switch();
+
+// Drops every translated block
+void cpu_dynarec_flush();
+
+// Releases the code buffer (instance teardown)
+void cpu_dynarec_free();
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <../headers/cpu.hpp>
+#include <../headers/bus.hpp>
+#include <../headers/main.hpp>
+#include <../headers/cpu_cache.hpp>
+
+// Immediate operands. On a decode cache hit they were read when the entry was
+// built and their M-cycles were already advanced together with the opcode.
+
+static inline u8 fetch_imm8(cpu_context *ctx) {
+    if (ctx->decoded) {
+        ctx->regs.pc++;
+        return ctx->decoded->operand & 0xFF;
+    }
+
+    u8 value = bus_read(ctx->regs.pc);
+    emu_cycles(1);
+    ctx->regs.pc++;
+
+    return value;
+}
+
+static inline u16 fetch_imm16(cpu_context *ctx) {
+    if (ctx->decoded) {
+        ctx->regs.pc += 2;
+        return ctx->decoded->operand;
+    }
+
+    u16 lo = bus_read(ctx->regs.pc);
+    emu_cycles(1);
+
+    u16 hi = bus_read(ctx->regs.pc + 1);
+    emu_cycles(1);
+
+    ctx->regs.pc += 2;
+    return lo | (hi << 8);
+}
+
+void fetch_data();
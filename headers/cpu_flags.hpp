@@ -0,0 +1,151 @@
+#pragma once
+
+#include <../headers/cpu.hpp>
+
+// Lazy flags: ALU ops that overwrite all four flags only record their
+// operands in ctx->lazy, and F is computed when something reads it
+// (conditions, PUSH AF, DAA, ADC/SBC, the debugger, cpu_get_regs()).
+// Set to 0 to compute F right after every op.
+#define CPU_LAZY_FLAGS 1
+
+typedef enum {
+    LF_NONE,
+    LF_ADD,         // result = a + b
+    LF_ADC,         // result = a + b + carry
+    LF_SUB,         // SUB and CP
+    LF_SBC,
+    LF_AND,         // result = a & b
+    LF_OR,          // OR and XOR
+    LF_INC,         // result = a + 1, C kept
+    LF_DEC,         // result = a - 1, C kept
+    LF_SHIFT        // CB rotates/shifts, carry = bit shifted out
+} lazy_flags_op;
+
+// ZNHC in the upper nibble for the recorded op
+static inline u8 lazy_flags_compute(const cpu_lazy_flags *lf) {
+    int a = lf->a;
+    int b = lf->b;
+    int c = lf->carry;
+    u8 z = 0, n = 0, h = 0, cy = 0;
+
+    switch(lf->op) {
+        case LF_ADD:
+            z = (lf->result & 0xFF) == 0;
+            h = (a & 0xF) + (b & 0xF) >= 0x10;
+            cy = lf->result >= 0x100;
+            break;
+
+        case LF_ADC:
+            z = (lf->result & 0xFF) == 0;
+            h = (a & 0xF) + (b & 0xF) + c > 0xF;
+            cy = lf->result > 0xFF;
+            break;
+
+        case LF_SUB:
+            z = a == b;
+            n = 1;
+            h = (a & 0xF) < (b & 0xF);
+            cy = a < b;
+            break;
+
+        case LF_SBC:
+            z = ((a - b - c) & 0xFF) == 0;
+            n = 1;
+            h = (a & 0xF) - (b & 0xF) - c < 0;
+            cy = a - b - c < 0;
+            break;
+
+        case LF_AND:
+            z = (lf->result & 0xFF) == 0;
+            h = 1;
+            break;
+
+        case LF_OR:
+            z = (lf->result & 0xFF) == 0;
+            break;
+
+        case LF_INC:
+            z = (lf->result & 0xFF) == 0;
+            h = (lf->result & 0x0F) == 0;
+            cy = c;
+            break;
+
+        case LF_DEC:
+            z = (lf->result & 0xFF) == 0;
+            n = 1;
+            h = (lf->result & 0x0F) == 0x0F;
+            cy = c;
+            break;
+
+        case LF_SHIFT:
+            z = (lf->result & 0xFF) == 0;
+            cy = c;
+            break;
+    }
+
+    return (z << 7) | (n << 6) | (h << 5) | (cy << 4);
+}
+
+// Writes the pending flags into regs.f (the low nibble is left alone)
+static inline void cpu_flags_sync(cpu_context *ctx) {
+    if (ctx->lazy.op != LF_NONE) {
+        ctx->regs.f = (ctx->regs.f & 0x0F) | lazy_flags_compute(&ctx->lazy);
+        ctx->lazy.op = LF_NONE;
+    }
+}
+
+static inline u8 cpu_flags(cpu_context *ctx) {
+    cpu_flags_sync(ctx);
+    return ctx->regs.f;
+}
+
+// Carry only, without materializing the rest of F
+static inline u8 cpu_flag_c(cpu_context *ctx) {
+    const cpu_lazy_flags *lf = &ctx->lazy;
+
+    switch(lf->op) {
+        case LF_NONE: return BIT(ctx->regs.f, 4);
+        case LF_ADD: return lf->result >= 0x100;
+        case LF_ADC: return lf->result > 0xFF;
+        case LF_SUB: return lf->a < lf->b;
+        case LF_SBC: return (int)lf->a - (int)lf->b - (int)lf->carry < 0;
+        case LF_AND:
+        case LF_OR: return 0;
+        default: return lf->carry;
+    }
+}
+
+static inline void cpu_flags_lazy(cpu_context *ctx, u8 op, u8 a, u8 b, u8 carry, u16 result) {
+    ctx->lazy.op = op;
+    ctx->lazy.a = a;
+    ctx->lazy.b = b;
+    ctx->lazy.carry = carry;
+    ctx->lazy.result = result;
+
+#if CPU_LAZY_FLAGS == 0
+    cpu_flags_sync(ctx);
+#endif
+}
+
+// Whole F is being replaced (POP AF, LD F), drop anything pending
+static inline void cpu_flags_set(cpu_context *ctx, u8 f) {
+    ctx->lazy.op = LF_NONE;
+    ctx->regs.f = f;
+}
+
+// BIT sets ZNH outright and keeps C, so F is written directly instead of
+// recording the op: the JR Z/NZ that usually follows reads it as is
+static inline void cpu_flags_bit(cpu_context *ctx, u8 tested) {
+    u8 f = (ctx->regs.f & 0x0F) | (cpu_flag_c(ctx) << 4) | (1 << 5);
+
+    if (!tested) {
+        f |= 1 << 7;
+    }
+
+    cpu_flags_set(ctx, f);
+}
+
+#define CPU_FLAG_Z BIT(cpu_flags(ctx), 7)
+#define CPU_FLAG_N BIT(cpu_flags(ctx), 6)
+#define CPU_FLAG_H BIT(cpu_flags(ctx), 5)
+#define CPU_FLAG_C cpu_flag_c(ctx)
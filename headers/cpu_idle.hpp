@@ -0,0 +1,49 @@
+#pragma once
+
+#include <../headers/common.hpp>
+#include <../headers/cpu.hpp>
+
+// Idle loop detection: short ROM loops that only read memory and wait for
+// something to change (LY, STAT, IF, an HRAM flag set by an interrupt...)
+// are fast-forwarded by whole iterations up to the next timer/PPU event.
+
+typedef struct {
+    u32 loops;              // Distinct idle loops found
+    u64 skips;              // Times a loop was fast-forwarded
+    u64 skipped_iterations;
+    u64 skipped_cycles;     // M-cycles fast-forwarded
+} cpu_idle_stats;
+
+#define IDLE_TABLE_SIZE 256
+
+typedef struct {
+    u16 pc;                         // The backward branch
+    u8 bank;                        // rom_bank_value for 0x4000 - 0x7FFF
+    u8 state;                       // idle_loop_state
+    u16 target;
+    u8 cycles;                      // M-cycles per iteration
+    u8 indirect;                    // idle_indirect mask
+    bool skipped;
+
+    cpu_regs regs;                  // Registers at the start of the last iteration
+    u64 ticks;
+    u64 stable_until;               // Reads can't change before this tick
+} idle_loop;
+
+typedef struct {
+    idle_loop loops[IDLE_TABLE_SIZE];
+    cpu_idle_stats stats;
+} cpu_idle_context;
+
+// Clears the loop table and the statistics (new ROM)
+void cpu_idle_init();
+
+// Called at an instruction boundary after the instruction at `from` moved
+// the PC backwards
+void cpu_idle_branch(u16 from);
+
+void cpu_idle_set_enabled(bool enabled);
+bool cpu_idle_enabled();
+
+const cpu_idle_stats *cpu_idle_get_stats();
+void cpu_idle_print_stats();
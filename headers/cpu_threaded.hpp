@@ -0,0 +1,7 @@
+#pragma once
+
+#include <../headers/common.hpp>
+
+// Runs up to `steps` instructions on the threaded-code core (computed goto).
+// Returns early when the CPU halts so the caller can keep its own loop going.
+bool cpu_threaded_exec(u32 steps);
@@ -5,5 +5,14 @@
 #include <../headers/common.hpp>   
 #include <../headers/cpu.hpp>
 
+typedef struct {
+    char msg[1024];             // Serial output, NUL-terminated
+    int size;
+} dbg_context;
+
 void dbg_update();
-void dbg_print();
\ No newline at end of file
+void dbg_print();
+
+// Bytes the ROM sent over the serial port, NUL-terminated
+const char *dbg_get_serial();
+int dbg_get_serial_size();
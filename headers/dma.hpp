@@ -2,7 +2,20 @@
 
 #include <../headers/common.hpp>
 
+#define DMA_BYTES 0xA0
+
+typedef struct{
+    bool active;
+    u8 value;
+    u8 data[DMA_BYTES];
+    u64 end;                    // Scheduler tick the lockout ends on
+} dma_context;
+
+// Copies the source right away, OAM gets it once the lockout window ends
 void dma_start (u8 start);
-void dma_tick();
 
-bool dma_transferring();
\ No newline at end of file
+// The CPU is locked out of OAM
+bool dma_transferring();
+
+// Posts the end of the transfer, the event also lands here
+void dma_schedule();
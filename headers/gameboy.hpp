@@ -0,0 +1,60 @@
+#pragma once
+
+#include <../headers/common.hpp>
+#include <../headers/main.hpp>
+#include <../headers/cart.hpp>
+#include <../headers/cpu.hpp>
+#include <../headers/cpu_cache.hpp>
+#include <../headers/cpu_dynarec.hpp>
+#include <../headers/cpu_idle.hpp>
+#include <../headers/ppu.hpp>
+#include <../headers/lcd.hpp>
+#include <../headers/timer.hpp>
+#include <../headers/dma.hpp>
+#include <../headers/ram.hpp>
+#include <../headers/io.hpp>
+#include <../headers/gamepad.hpp>
+#include <../headers/scheduler.hpp>
+#include <../headers/dbg.hpp>
+
+// One emulated Game Boy: the state of every component. The core functions
+// work on the instance bound to the calling thread (`gb`), so independent
+// instances can run in one process as long as each has its own thread.
+// An instance can run one cart after another: cart_load() resets the cart
+// and emu_init() everything else but the settings.
+
+typedef struct {
+    emu_context emu;
+    cart_context cart;
+    cpu_context cpu;
+    cpu_cache_context cpu_cache;
+    cpu_idle_context idle;
+    jit_context jit;
+    ppu_context ppu;
+    lcd_context lcd;
+    timer_context timer;
+    dma_context dma;
+    ram_context ram;
+    io_context io;
+    gamepad_context gamepad;
+    sched_context sched;
+    dbg_context dbg;
+
+    // Settings, emu_init() leaves them alone
+    cpu_core core;
+    bool idle_skip;
+    bool scanline;
+} gameboy;
+
+// The instance this thread runs, set with gb_bind()
+inline thread_local gameboy *gb = nullptr;
+
+// Zeroed instance with the default settings and no cart
+gameboy *gb_create();
+
+// Frees the cart, the frame buffers and the translated code, unbinds it
+// from the calling thread
+void gb_destroy(gameboy *instance);
+
+// Points this thread's core functions at `instance`
+void gb_bind(gameboy *instance);
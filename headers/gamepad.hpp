@@ -13,6 +13,12 @@ typedef struct{
     bool right;
 } gamepad_state;
 
+typedef struct {
+    bool button_selected;
+    bool dir_selected;
+    gamepad_state controller;
+} gamepad_context;
+
 void gamepad_init();
 bool gamepad_button_selected();
 bool gamepad_dir_selected();
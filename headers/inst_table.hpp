@@ -0,0 +1,321 @@
+#pragma once
+
+#include <../headers/instructions.hpp>
+#include <array>
+
+// Opcode table, built at compile time so the per-opcode handlers in
+// cpu_ops.cpp can specialize on addressing mode and registers.
+// Entries that aren't listed stay {IN_NONE, AM_IMP, RT_NONE, RT_NONE, CT_NONE, 0}.
+
+// Every field initialized, trailing ones default like the table's blanks
+constexpr instruction inst(in_type type, addr_mode mode = AM_IMP, reg_type reg_1 = RT_NONE,
+                           reg_type reg_2 = RT_NONE, cond_type cond = CT_NONE, u8 param = 0) {
+    return {type, mode, reg_1, reg_2, cond, param};
+}
+
+constexpr std::array<instruction, 256> make_instruction_table() {
+    std::array<instruction, 256> t = {};
+
+    //0x0X
+    t[0x00] = inst(IN_NOP,  AM_IMP);
+    t[0x01] = inst(IN_LD,  AM_R_D16,  RT_BC);
+    t[0x02] = inst(IN_LD,  AM_MR_R,  RT_BC,  RT_A);
+    t[0x03] = inst(IN_INC,  AM_R,  RT_BC);
+    t[0x04] = inst(IN_INC,  AM_R,  RT_B);
+    t[0x05] = inst(IN_DEC,  AM_R,  RT_B);
+    t[0x06] = inst(IN_LD,  AM_R_D8,  RT_B);
+    t[0x07] = inst(IN_RLCA);
+    t[0x08] = inst(IN_LD,  AM_A16_R,  RT_NONE,  RT_SP);
+    t[0x09] = inst(IN_ADD,  AM_R_R,  RT_HL,  RT_BC);
+    t[0x0A] = inst(IN_LD,  AM_R_MR,  RT_A,  RT_BC);
+    t[0x0B] = inst(IN_DEC,  AM_R,  RT_BC);
+    t[0x0C] = inst(IN_INC,  AM_R,  RT_C);
+    t[0x0D] = inst(IN_DEC,  AM_R,  RT_C);
+    t[0x0E] = inst(IN_LD,  AM_R_D8,  RT_C);
+    t[0x0F] = inst(IN_RRCA);
+
+    //0x1X
+    t[0x10] = inst(IN_STOP);
+    t[0x11] = inst(IN_LD,  AM_R_D16,  RT_DE);
+    t[0x12] = inst(IN_LD,  AM_MR_R,  RT_DE,  RT_A);
+    t[0x13] = inst(IN_INC,  AM_R,  RT_DE);
+    t[0x14] = inst(IN_INC,  AM_R,  RT_D);
+    t[0x15] = inst(IN_DEC,  AM_R,  RT_D);
+    t[0x16] = inst(IN_LD,  AM_R_D8,  RT_D);
+    t[0x17] = inst(IN_RLA);
+    t[0x18] = inst(IN_JR,  AM_D8);
+    t[0x19] = inst(IN_ADD,  AM_R_R,  RT_HL,  RT_DE);
+    t[0x1A] = inst(IN_LD,  AM_R_MR,  RT_A,  RT_DE);
+    t[0x1B] = inst(IN_DEC,  AM_R,  RT_DE);
+    t[0x1C] = inst(IN_INC,  AM_R,  RT_E);
+    t[0x1D] = inst(IN_DEC,  AM_R,  RT_E);
+    t[0x1E] = inst(IN_LD,  AM_R_D8,  RT_E);
+    t[0x1F] = inst(IN_RRA);
+
+    //0x2X
+    t[0x20] = inst(IN_JR,  AM_D8,  RT_NONE,  RT_NONE,  CT_NZ);
+    t[0x21] = inst(IN_LD,  AM_R_D16,  RT_HL);
+    t[0x22] = inst(IN_LD,  AM_HLI_R,  RT_HL,  RT_A);
+    t[0x23] = inst(IN_INC,  AM_R,  RT_HL);
+    t[0x24] = inst(IN_INC,  AM_R,  RT_H);
+    t[0x25] = inst(IN_DEC,  AM_R,  RT_H);
+    t[0x26] = inst(IN_LD,  AM_R_D8,  RT_H);
+    t[0x27] = inst(IN_DAA);
+    t[0x28] = inst(IN_JR,  AM_D8,  RT_NONE,  RT_NONE,  CT_Z);
+    t[0x29] = inst(IN_ADD,  AM_R_R,  RT_HL,  RT_HL);
+    t[0x2A] = inst(IN_LD,  AM_R_HLI,  RT_A,  RT_HL);
+    t[0x2B] = inst(IN_DEC,  AM_R,  RT_HL);
+    t[0x2C] = inst(IN_INC,  AM_R,  RT_L);
+    t[0x2D] = inst(IN_DEC,  AM_R,  RT_L);
+    t[0x2E] = inst(IN_LD,  AM_R_D8,  RT_L);
+    t[0x2F] = inst(IN_CPL);
+
+    //0x3X
+    t[0x30] = inst(IN_JR,  AM_D8,  RT_NONE,  RT_NONE,  CT_NC);
+    t[0x31] = inst(IN_LD,  AM_R_D16,  RT_SP);
+    t[0x32] = inst(IN_LD,  AM_HLD_R,  RT_HL,  RT_A);
+    t[0x33] = inst(IN_INC,  AM_R,  RT_SP);
+    t[0x34] = inst(IN_INC,  AM_MR,  RT_HL);
+    t[0x35] = inst(IN_DEC,  AM_MR,  RT_HL);
+    t[0x36] = inst(IN_LD,  AM_MR_D8,  RT_HL);
+    t[0x37] = inst(IN_SCF);
+    t[0x38] = inst(IN_JR,  AM_D8,  RT_NONE,  RT_NONE,  CT_C);
+    t[0x39] = inst(IN_ADD,  AM_R_R,  RT_HL,  RT_SP);
+    t[0x3A] = inst(IN_LD,  AM_R_HLD,  RT_A,  RT_HL);
+    t[0x3B] = inst(IN_DEC,  AM_R,  RT_SP);
+    t[0x3C] = inst(IN_INC,  AM_R,  RT_A);
+    t[0x3D] = inst(IN_DEC,  AM_R,  RT_A);
+    t[0x3E] = inst(IN_LD,  AM_R_D8,  RT_A);
+    t[0x3F] = inst(IN_CCF);
+
+    //0x4X
+    t[0x40] = inst(IN_LD,  AM_R_R,  RT_B,  RT_B);
+    t[0x41] = inst(IN_LD,  AM_R_R,  RT_B,  RT_C);
+    t[0x42] = inst(IN_LD,  AM_R_R,  RT_B,  RT_D);
+    t[0x43] = inst(IN_LD,  AM_R_R,  RT_B,  RT_E);
+    t[0x44] = inst(IN_LD,  AM_R_R,  RT_B,  RT_H);
+    t[0x45] = inst(IN_LD,  AM_R_R,  RT_B,  RT_L);
+    t[0x46] = inst(IN_LD,  AM_R_MR,  RT_B,  RT_HL);
+    t[0x47] = inst(IN_LD,  AM_R_R,  RT_B,  RT_A);
+    t[0x48] = inst(IN_LD,  AM_R_R,  RT_C,  RT_B);
+    t[0x49] = inst(IN_LD,  AM_R_R,  RT_C,  RT_C);
+    t[0x4A] = inst(IN_LD,  AM_R_R,  RT_C,  RT_D);
+    t[0x4B] = inst(IN_LD,  AM_R_R,  RT_C,  RT_E);
+    t[0x4C] = inst(IN_LD,  AM_R_R,  RT_C,  RT_H);
+    t[0x4D] = inst(IN_LD,  AM_R_R,  RT_C,  RT_L);
+    t[0x4E] = inst(IN_LD,  AM_R_MR,  RT_C,  RT_HL);
+    t[0x4F] = inst(IN_LD,  AM_R_R,  RT_C,  RT_A);
+
+    //0x5X
+    t[0x50] = inst(IN_LD,  AM_R_R,   RT_D,  RT_B);
+    t[0x51] = inst(IN_LD,  AM_R_R,   RT_D,  RT_C);
+    t[0x52] = inst(IN_LD,  AM_R_R,   RT_D,  RT_D);
+    t[0x53] = inst(IN_LD,  AM_R_R,   RT_D,  RT_E);
+    t[0x54] = inst(IN_LD,  AM_R_R,   RT_D,  RT_H);
+    t[0x55] = inst(IN_LD,  AM_R_R,   RT_D,  RT_L);
+    t[0x56] = inst(IN_LD,  AM_R_MR,  RT_D,  RT_HL);
+    t[0x57] = inst(IN_LD,  AM_R_R,   RT_D,  RT_A);
+    t[0x58] = inst(IN_LD,  AM_R_R,   RT_E,  RT_B);
+    t[0x59] = inst(IN_LD,  AM_R_R,   RT_E,  RT_C);
+    t[0x5A] = inst(IN_LD,  AM_R_R,   RT_E,  RT_D);
+    t[0x5B] = inst(IN_LD,  AM_R_R,   RT_E,  RT_E);
+    t[0x5C] = inst(IN_LD,  AM_R_R,   RT_E,  RT_H);
+    t[0x5D] = inst(IN_LD,  AM_R_R,   RT_E,  RT_L);
+    t[0x5E] = inst(IN_LD,  AM_R_MR,  RT_E,  RT_HL);
+    t[0x5F] = inst(IN_LD,  AM_R_R,   RT_E,  RT_A);
+
+    //0x6X
+    t[0x60] = inst(IN_LD,  AM_R_R,   RT_H,  RT_B);
+    t[0x61] = inst(IN_LD,  AM_R_R,   RT_H,  RT_C);
+    t[0x62] = inst(IN_LD,  AM_R_R,   RT_H,  RT_D);
+    t[0x63] = inst(IN_LD,  AM_R_R,   RT_H,  RT_E);
+    t[0x64] = inst(IN_LD,  AM_R_R,   RT_H,  RT_H);
+    t[0x65] = inst(IN_LD,  AM_R_R,   RT_H,  RT_L);
+    t[0x66] = inst(IN_LD,  AM_R_MR,  RT_H,  RT_HL);
+    t[0x67] = inst(IN_LD,  AM_R_R,   RT_H,  RT_A);
+    t[0x68] = inst(IN_LD,  AM_R_R,   RT_L,  RT_B);
+    t[0x69] = inst(IN_LD,  AM_R_R,   RT_L,  RT_C);
+    t[0x6A] = inst(IN_LD,  AM_R_R,   RT_L,  RT_D);
+    t[0x6B] = inst(IN_LD,  AM_R_R,   RT_L,  RT_E);
+    t[0x6C] = inst(IN_LD,  AM_R_R,   RT_L,  RT_H);
+    t[0x6D] = inst(IN_LD,  AM_R_R,   RT_L,  RT_L);
+    t[0x6E] = inst(IN_LD,  AM_R_MR,  RT_L,  RT_HL);
+    t[0x6F] = inst(IN_LD,  AM_R_R,   RT_L,  RT_A);
+
+    //0x7X
+    t[0x70] = inst(IN_LD,  AM_MR_R,   RT_HL,  RT_B);
+    t[0x71] = inst(IN_LD,  AM_MR_R,   RT_HL,  RT_C);
+    t[0x72] = inst(IN_LD,  AM_MR_R,   RT_HL,  RT_D);
+    t[0x73] = inst(IN_LD,  AM_MR_R,   RT_HL,  RT_E);
+    t[0x74] = inst(IN_LD,  AM_MR_R,   RT_HL,  RT_H);
+    t[0x75] = inst(IN_LD,  AM_MR_R,   RT_HL,  RT_L);
+    t[0x76] = inst(IN_HALT);
+    t[0x77] = inst(IN_LD,  AM_MR_R,   RT_HL,  RT_A);
+    t[0x78] = inst(IN_LD,  AM_R_R,   RT_A,  RT_B);
+    t[0x79] = inst(IN_LD,  AM_R_R,   RT_A,  RT_C);
+    t[0x7A] = inst(IN_LD,  AM_R_R,   RT_A,  RT_D);
+    t[0x7B] = inst(IN_LD,  AM_R_R,   RT_A,  RT_E);
+    t[0x7C] = inst(IN_LD,  AM_R_R,   RT_A,  RT_H);
+    t[0x7D] = inst(IN_LD,  AM_R_R,   RT_A,  RT_L);
+    t[0x7E] = inst(IN_LD,  AM_R_MR,  RT_A,  RT_HL);
+    t[0x7F] = inst(IN_LD,  AM_R_R,   RT_A,  RT_A);
+
+    //0x8X
+    t[0x80] = inst(IN_ADD,  AM_R_R,  RT_A,  RT_B);
+    t[0x81] = inst(IN_ADD,  AM_R_R,  RT_A,  RT_C);
+    t[0x82] = inst(IN_ADD,  AM_R_R,  RT_A,  RT_D);
+    t[0x83] = inst(IN_ADD,  AM_R_R,  RT_A,  RT_E);
+    t[0x84] = inst(IN_ADD,  AM_R_R,  RT_A,  RT_H);
+    t[0x85] = inst(IN_ADD,  AM_R_R,  RT_A,  RT_L);
+    t[0x86] = inst(IN_ADD,  AM_R_MR,  RT_A,  RT_HL);
+    t[0x87] = inst(IN_ADD,  AM_R_R,  RT_A,  RT_A);
+    t[0x88] = inst(IN_ADC,  AM_R_R,  RT_A,  RT_B);
+    t[0x89] = inst(IN_ADC,  AM_R_R,  RT_A,  RT_C);
+    t[0x8A] = inst(IN_ADC,  AM_R_R,  RT_A,  RT_D);
+    t[0x8B] = inst(IN_ADC,  AM_R_R,  RT_A,  RT_E);
+    t[0x8C] = inst(IN_ADC,  AM_R_R,  RT_A,  RT_H);
+    t[0x8D] = inst(IN_ADC,  AM_R_R,  RT_A,  RT_L);
+    t[0x8E] = inst(IN_ADC,  AM_R_MR,  RT_A,  RT_HL);
+    t[0x8F] = inst(IN_ADC,  AM_R_R,  RT_A,  RT_A);
+
+    //0x9X
+    t[0x90] = inst(IN_SUB,  AM_R_R,  RT_A,  RT_B);
+    t[0x91] = inst(IN_SUB,  AM_R_R,  RT_A,  RT_C);
+    t[0x92] = inst(IN_SUB,  AM_R_R,  RT_A,  RT_D);
+    t[0x93] = inst(IN_SUB,  AM_R_R,  RT_A,  RT_E);
+    t[0x94] = inst(IN_SUB,  AM_R_R,  RT_A,  RT_H);
+    t[0x95] = inst(IN_SUB,  AM_R_R,  RT_A,  RT_L);
+    t[0x96] = inst(IN_SUB,  AM_R_MR,  RT_A,  RT_HL);
+    t[0x97] = inst(IN_SUB,  AM_R_R,  RT_A,  RT_A);
+    t[0x98] = inst(IN_SBC,  AM_R_R,  RT_A,  RT_B);
+    t[0x99] = inst(IN_SBC,  AM_R_R,  RT_A,  RT_C);
+    t[0x9A] = inst(IN_SBC,  AM_R_R,  RT_A,  RT_D);
+    t[0x9B] = inst(IN_SBC,  AM_R_R,  RT_A,  RT_E);
+    t[0x9C] = inst(IN_SBC,  AM_R_R,  RT_A,  RT_H);
+    t[0x9D] = inst(IN_SBC,  AM_R_R,  RT_A,  RT_L);
+    t[0x9E] = inst(IN_SBC,  AM_R_MR,  RT_A,  RT_HL);
+    t[0x9F] = inst(IN_SBC,  AM_R_R,  RT_A,  RT_A);
+
+    //0xAX
+    t[0xA0] = inst(IN_AND,  AM_R_R,  RT_A,  RT_B);
+    t[0xA1] = inst(IN_AND,  AM_R_R,  RT_A,  RT_C);
+    t[0xA2] = inst(IN_AND,  AM_R_R,  RT_A,  RT_D);
+    t[0xA3] = inst(IN_AND,  AM_R_R,  RT_A,  RT_E);
+    t[0xA4] = inst(IN_AND,  AM_R_R,  RT_A,  RT_H);
+    t[0xA5] = inst(IN_AND,  AM_R_R,  RT_A,  RT_L);
+    t[0xA6] = inst(IN_AND,  AM_R_MR,  RT_A,  RT_HL);
+    t[0xA7] = inst(IN_AND,  AM_R_R,  RT_A,  RT_A);
+    t[0xA8] = inst(IN_XOR,  AM_R_R,  RT_A,  RT_B);
+    t[0xA9] = inst(IN_XOR,  AM_R_R,  RT_A,  RT_C);
+    t[0xAA] = inst(IN_XOR,  AM_R_R,  RT_A,  RT_D);
+    t[0xAB] = inst(IN_XOR,  AM_R_R,  RT_A,  RT_E);
+    t[0xAC] = inst(IN_XOR,  AM_R_R,  RT_A,  RT_H);
+    t[0xAD] = inst(IN_XOR,  AM_R_R,  RT_A,  RT_L);
+    t[0xAE] = inst(IN_XOR,  AM_R_MR,  RT_A,  RT_HL);
+    t[0xAF] = inst(IN_XOR,  AM_R_R,  RT_A,  RT_A);
+
+    //0xBX
+    t[0xB0] = inst(IN_OR,  AM_R_R,  RT_A,  RT_B);
+    t[0xB1] = inst(IN_OR,  AM_R_R,  RT_A,  RT_C);
+    t[0xB2] = inst(IN_OR,  AM_R_R,  RT_A,  RT_D);
+    t[0xB3] = inst(IN_OR,  AM_R_R,  RT_A,  RT_E);
+    t[0xB4] = inst(IN_OR,  AM_R_R,  RT_A,  RT_H);
+    t[0xB5] = inst(IN_OR,  AM_R_R,  RT_A,  RT_L);
+    t[0xB6] = inst(IN_OR,  AM_R_MR,  RT_A,  RT_HL);
+    t[0xB7] = inst(IN_OR,  AM_R_R,  RT_A,  RT_A);
+    t[0xB8] = inst(IN_CP,  AM_R_R,  RT_A,  RT_B);
+    t[0xB9] = inst(IN_CP,  AM_R_R,  RT_A,  RT_C);
+    t[0xBA] = inst(IN_CP,  AM_R_R,  RT_A,  RT_D);
+    t[0xBB] = inst(IN_CP,  AM_R_R,  RT_A,  RT_E);
+    t[0xBC] = inst(IN_CP,  AM_R_R,  RT_A,  RT_H);
+    t[0xBD] = inst(IN_CP,  AM_R_R,  RT_A,  RT_L);
+    t[0xBE] = inst(IN_CP,  AM_R_MR,  RT_A,  RT_HL);
+    t[0xBF] = inst(IN_CP,  AM_R_R,  RT_A,  RT_A);
+
+    t[0xC0] = inst(IN_RET,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NZ);
+    t[0xC1] = inst(IN_POP,  AM_R,  RT_BC);
+    t[0xC2] = inst(IN_JP,  AM_D16,  RT_NONE,  RT_NONE,  CT_NZ);
+    t[0xC3] = inst(IN_JP,  AM_D16);
+    t[0xC4] = inst(IN_CALL,  AM_D16,  RT_NONE,  RT_NONE,  CT_NZ);
+    t[0xC5] = inst(IN_PUSH,  AM_R,  RT_BC);
+    t[0xC6] = inst(IN_ADD,  AM_R_D8,  RT_A);
+    t[0xC7] = inst(IN_RST,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NONE,  0x00);
+    t[0xC8] = inst(IN_RET,  AM_IMP,  RT_NONE,  RT_NONE,  CT_Z);
+    t[0xC9] = inst(IN_RET);
+    t[0xCA] = inst(IN_JP,  AM_D16,  RT_NONE,  RT_NONE,  CT_Z);
+    t[0xCB] = inst(IN_CB,  AM_D8);
+    t[0xCC] = inst(IN_CALL,  AM_D16,  RT_NONE,  RT_NONE,  CT_Z);
+    t[0xCD] = inst(IN_CALL,  AM_D16);
+    t[0xCE] = inst(IN_ADC,  AM_R_D8,  RT_A);
+    t[0xCF] = inst(IN_RST,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NONE,  0x08);
+
+    t[0xD0] = inst(IN_RET,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NC);
+    t[0xD1] = inst(IN_POP,  AM_R,  RT_DE);
+    t[0xD2] = inst(IN_JP,  AM_D16,  RT_NONE,  RT_NONE,  CT_NC);
+    t[0xD4] = inst(IN_CALL,  AM_D16,  RT_NONE,  RT_NONE,  CT_NC);
+    t[0xD5] = inst(IN_PUSH,  AM_R,  RT_DE);
+    t[0xD6] = inst(IN_SUB,  AM_R_D8,  RT_A);
+    t[0xD7] = inst(IN_RST,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NONE,  0x10);
+    t[0xD8] = inst(IN_RET,  AM_IMP,  RT_NONE,  RT_NONE,  CT_C);
+    t[0xD9] = inst(IN_RETI);
+    t[0xDA] = inst(IN_JP,  AM_D16,  RT_NONE,  RT_NONE,  CT_C);
+    t[0xDC] = inst(IN_CALL,  AM_D16,  RT_NONE,  RT_NONE,  CT_C);
+    t[0xDE] = inst(IN_SBC,  AM_R_D8,  RT_A);
+    t[0xDF] = inst(IN_RST,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NONE,  0x18);
+
+    //0xEX
+    t[0xE0] = inst(IN_LDH,  AM_A8_R,  RT_NONE,  RT_A);
+    t[0xE1] = inst(IN_POP,  AM_R,  RT_HL);
+    t[0xE2] = inst(IN_LD,  AM_MR_R,  RT_C,  RT_A);
+    t[0xE5] = inst(IN_PUSH,  AM_R,  RT_HL);
+    t[0xE6] = inst(IN_AND,  AM_R_D8,  RT_A);
+    t[0xE7] = inst(IN_RST,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NONE,  0x20);
+    t[0xE8] = inst(IN_ADD,  AM_R_D8,  RT_SP);
+    t[0xE9] = inst(IN_JP,  AM_R,  RT_HL);
+    t[0xEA] = inst(IN_LD,  AM_A16_R,  RT_NONE,  RT_A);
+    t[0xEE] = inst(IN_XOR,  AM_R_D8,  RT_A);
+    t[0xEF] = inst(IN_RST,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NONE,  0x28);
+
+    //0xFX
+    t[0xF0] = inst(IN_LDH,  AM_R_A8,  RT_A);
+    t[0xF1] = inst(IN_POP,  AM_R,  RT_AF);
+    t[0xF2] = inst(IN_LD,  AM_R_MR,  RT_A,  RT_C);
+    t[0xF3] = inst(IN_DI);
+    t[0xF5] = inst(IN_PUSH,  AM_R,  RT_AF);
+    t[0xF6] = inst(IN_OR,  AM_R_D8,  RT_A);
+    t[0xF7] = inst(IN_RST,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NONE,  0x30);
+    t[0xF8] = inst(IN_LD,  AM_HL_SPR,  RT_HL,  RT_SP);
+    t[0xF9] = inst(IN_LD,  AM_R_R,  RT_SP,  RT_HL);
+    t[0xFA] = inst(IN_LD,  AM_R_A16,  RT_A);
+    t[0xFB] = inst(IN_EI);
+    t[0xFC] = inst(IN_CALL, AM_R_A16, RT_C);
+    t[0xFE] = inst(IN_CP,  AM_R_D8,  RT_A);
+    t[0xFF] = inst(IN_RST,  AM_IMP,  RT_NONE,  RT_NONE,  CT_NONE,  0x38);
+
+    return t;
+}
+
+inline constexpr std::array<instruction, 256> inst_table = make_instruction_table();
+
+// Immediate bytes that follow the opcode for each addressing mode
+constexpr u8 inst_immediate_bytes(addr_mode mode) {
+    switch(mode) {
+        case AM_R_D8:
+        case AM_R_A8:
+        case AM_A8_R:
+        case AM_HL_SPR:
+        case AM_D8:
+        case AM_MR_D8:
+            return 1;
+
+        case AM_R_D16:
+        case AM_D16:
+        case AM_D16_R:
+        case AM_A16_R:
+        case AM_R_A16:
+            return 2;
+
+        default:
+            return 0;
+    }
+}
@@ -110,7 +110,6 @@ typedef struct {
     u8 param;
 } instruction;
 
-instruction *instruction_by_opcode(u8 opcode);
-void init_instructions();
+const instruction *instruction_by_opcode(u8 opcode);
 
 char *inst_name(in_type t);
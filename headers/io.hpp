@@ -2,5 +2,9 @@
 
 #include <../headers/common.hpp>
 
+typedef struct {
+    char serial_data[2];        // SB, SC
+} io_context;
+
 u8 io_read(u16 address);
 void io_write(u16 address, u8 value);
\ No newline at end of file
@@ -2,17 +2,87 @@
 
 #include <../headers/common.hpp>
 #include <string>
+#include <pthread.h>
+
+// Called on the emulation thread after every published frame, see
+// emu_set_frame_callback()
+typedef void (*emu_frame_callback)(void *user);
+
+// Commands for the emulation thread, see emu_command_post()
+typedef enum {
+    EMU_CMD_RUN,
+    EMU_CMD_PAUSE,
+    EMU_CMD_STEP,               // One instruction, then paused
+    EMU_CMD_STEP_FRAME,         // Up to the next VBlank, then paused
+    EMU_CMD_QUIT
+} emu_command;
 
 typedef struct {
     bool paused;
     bool running;
     bool die;
     u64 ticks;
+
+    // Command channel, the emulation thread sleeps on `control_cond` while
+    // paused. Set up by gb_create().
+    pthread_mutex_t control_lock;
+    pthread_cond_t control_cond;
+    u32 steps;                  // EMU_CMD_STEP not run yet
+    u32 frame_steps;            // EMU_CMD_STEP_FRAME not started yet
+    bool frame_stepping;
+    u32 frame_start;            // current_frame when the frame step started
+    bool quit;
+
+    // Catch-up timing: the CPU banks M-cycles in `pending` and the timer, PPU
+    // and DMA only run them at emu_sync(). `budget` is how many they can take
+    // before the next scheduled event, so nothing is lost while pending <= budget.
+    u32 pending;
+    u32 budget;
+
+    // Front end hook for new frames, NULL when nobody waits on them
+    emu_frame_callback frame_callback;
+    void *frame_user;
 } emu_context;
 
+// Instructions run per cpu_exec() call before checking the command channel
+#define CPU_EXEC_BATCH 256
+
 int emu_run(std::string);
 
 emu_context *emu_get_context();
 
+// Resets the timer, CPU, PPU and scheduler for the loaded cart (emu.cpp)
+void emu_init();
+
+// Registers the front end's frame callback for the bound instance, `user`
+// is passed back to it. NULL turns it off.
+void emu_set_frame_callback(emu_frame_callback callback, void *user);
+
+// Emulation thread: a frame was published, runs the frame callback
+void emu_frame_done();
+
+// Any thread: queues a command for the emulation thread and wakes it
+void emu_command_post(emu_command cmd);
+
+// Emulation thread, before every cpu_exec(): instructions to run next.
+// Blocks without polling while paused, 0 once EMU_CMD_QUIT was posted.
+u32 emu_command_wait();
+
+// Advances the CPU clock, `ticks` is always current
 void emu_cycles(int cpu_cycles);
 
+// Runs the pending cycles on the timer, PPU and DMA. Called before the CPU
+// touches memory they own and at the end of cpu_exec().
+void emu_sync();
+
+// Reposts every event after a write that can move one (TAC, DIV, LCDC, DMA
+// start...), the components have to be synced
+void emu_sync_invalidate();
+
+// M-cycles the timer, PPU and DMA only count through before one of them can
+// raise an interrupt or change a register. Syncs first.
+u32 emu_idle_cycles();
+
+// Same as emu_cycles(), for at most emu_idle_cycles() cycles
+void emu_skip_cycles(u32 cpu_cycles);
+
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <../headers/common.hpp>
+
+// Frame pacing for the emulation thread: holds each frame to the DMG refresh
+// rate (70224 T-cycles at 4.194304 MHz, 59.7275 Hz) times the speed
+// multiplier, or lets it run uncapped. Waits sleep until close to the
+// deadline and spin the rest, the scheduler can't wake a thread that precisely.
+
+#define PACING_TICKS_PER_FRAME  70224
+#define PACING_CLOCK_HZ         4194304
+#define PACING_SPEED_MIN        0.25
+#define PACING_SPEED_MAX        16.0
+
+void pacing_init();
+
+// Clamped to PACING_SPEED_MIN - PACING_SPEED_MAX
+void pacing_set_speed(double speed);
+double pacing_get_speed();
+
+void pacing_set_uncapped(bool uncapped);
+bool pacing_uncapped();
+
+// Monotonic clock in nanoseconds
+u64 pacing_now_ns();
+
+// Called once per emulated frame, waits until it's due. Returns true once a
+// second, when the FPS count rolls over.
+bool pacing_frame();
+
+// Frames in the last whole second
+u32 pacing_fps();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <../headers/common.hpp>
+#include <atomic>
 
 // PANDOCS - Rendering - Pixel FIFO
 static const int LINES_PER_FRAME = 154;
@@ -8,6 +9,9 @@ static const int TICKS_PER_LINE  = 456;
 static const int YRES            = 144;
 static const int XRES            = 160;
 
+#define PPU_FRAME_BUFFERS 3
+#define PPU_FRAME_FRESH   0x80
+
 typedef enum {
     FS_TILE,
     FS_DATA0,
@@ -19,14 +23,15 @@ typedef enum {
 
 // FIFO Structure:
 
-typedef struct _fifo_entry{
-    struct _fifo_entry *next;
-    u32 value;
-} fifo_entry;
+// Pixels are only fetched while at most 8 are queued, 8 at a time, so 16
+// always fit. Power of two so the indexes wrap with a mask.
+#define PIXEL_FIFO_SIZE 16
+#define PIXEL_FIFO_MASK (PIXEL_FIFO_SIZE - 1)
 
 typedef struct {
-    fifo_entry *head;
-    fifo_entry *tail;
+    u32 entries[PIXEL_FIFO_SIZE];   // Final colors, resolved when fetched
+    u8 head;
+    u8 tail;
     u32 size;
 } fifo;
 
@@ -40,6 +45,7 @@ typedef struct{
 
     u8 bgw_fetch_data[3];
     u8 fetch_entry_data[6];
+    u8 fetch_entry_pixels[3][8];    // fetch_entry_data decoded, left to right
 
     u8 map_y;
     u8 map_x;
@@ -74,26 +80,51 @@ typedef struct {
 
 } oam_entry;
 
-typedef struct _oam_line_entry{
-    oam_entry entry;
-    struct _oam_line_entry *next;
-} oam_line_entry;
+#define OAM_ENTRIES      40
+#define LINE_SPRITES_MAX 10
+
+// OAM binned by line (ppu_oam.cpp), kept up to date by ppu_oam_write()
+typedef struct {
+    u64 masks[YRES];                        // Bit n: entry n covers the line
+    u8 sprites[YRES][LINE_SPRITES_MAX];     // Entries the line draws, sorted by X
+    u8 counts[YRES];
+    bool dirty[YRES];                       // sprites and counts need a re-sort
+    u8 height;                              // Sprite height of the masks, 0 to rebuild
+} oam_bins;
+
+// Tile data (0x8000 - 0x97FF) decoded to one color index per pixel,
+// refreshed on the first read after a VRAM write to the tile
+#define PPU_TILE_COUNT 384
+
+typedef struct {
+    u8 pixels[PPU_TILE_COUNT][8][8];        // [tile][row][x], left to right
+    u8 flipped[PPU_TILE_COUNT][8][8];       // Same, mirrored for x-flipped sprites
+    bool dirty[PPU_TILE_COUNT];
+} ppu_tile_cache;
+
+// Mode 3 lines per renderer (ppu_line.cpp)
+typedef struct {
+    u64 scanline;
+    u64 fifo;                       // Fallbacks included
+    u64 fallbacks;                  // Started as scanline, register or VRAM write in mode 3
+    u64 tile_decodes;               // Tile cache refills
+} ppu_line_stats;
 
 typedef struct {
     
-    oam_entry oam_ram[40];
+    oam_entry oam_ram[OAM_ENTRIES];
     u8 vram[0x2000];
+    ppu_tile_cache tiles;
     
     pixel_fifo_context pfc;
     
     // 0 - 10 sprites
     u8 line_sprite_count;
 
-    // Current sprites in line
-    oam_line_entry *line_sprites;
+    // Current sprites in line, copied from OAM on its first tick, sorted by X
+    oam_entry line_sprites[LINE_SPRITES_MAX];
 
-    // OAM Memory
-    oam_line_entry line_entry_array[10];
+    oam_bins bins;
 
     u8 fetched_entry_count;
     oam_entry fetched_entries[3];
@@ -102,23 +133,80 @@ typedef struct {
 
     u32 current_frame;
     u32 line_ticks;
+
+    // This mode 3 is drawn by ppu_line_render() on line_end
+    bool line_fast;
+    u16 line_end;
+    ppu_line_stats line_stats;
+
+    // Triple buffering: the PPU draws into video_buffer (frame_buffers[back])
+    // and swaps it with `ready` at VBlank, the UI swaps `front` with `ready`
+    // when it holds a newer frame. Neither side ever waits on the other.
     u32 *video_buffer;
+    u32 *frame_buffers[PPU_FRAME_BUFFERS];
+    u8 back;
+    u8 front;
+    std::atomic<u8> ready;          // Slot, | PPU_FRAME_FRESH until the UI takes it
 
 } ppu_context;
 
 ppu_context *ppu_get_context();
 
 void ppu_init();
+
+// Frees the frame buffers (instance teardown)
+void ppu_free();
 void ppu_tick();
+
+// T-cycles ppu_tick() does nothing but count line_ticks for
+u32 ppu_idle_ticks();
+void ppu_skip(u32 ticks);
+
+// Posts the next mode change (or the next dot during pixel transfer)
+void ppu_schedule();
+ 
+// VBlank: the frame just drawn becomes the UI's next one
+void ppu_frame_publish();
+
+// UI thread: the newest complete frame, stays valid until the next call
+const u32 *ppu_frame_acquire();
  
 void ppu_oam_write(u16 address, u8 value);
 u8 ppu_oam_read(u16 address);
 
+// Sprite bins: rebuilt on the next line (OAM cleared)
+void oam_bins_reset();
+
+// Entry `index` got a new Y or X, it had `old_y`
+void oam_bins_moved(u8 index, u8 old_y);
+
+// The line's sprites as OAM indexes, sorted by X
+const u8 *oam_bins_line(u8 line, u8 *count);
+
 void ppu_vram_write(u16 address, u8 value);
 u8 ppu_vram_read(u16 address);
 
+// Decodes a dirty tile into the tile cache
+void ppu_tile_decode(u16 tile);
+
 void pipeline_process();
 void pipeline_fifo_reset();
 
+// Scanline renderer, the FIFO stays the fallback (on by default)
+void ppu_line_set_enabled(bool enabled);
+bool ppu_line_enabled();
+
+// Mode 3 starts: picks the renderer for this line
+void ppu_line_begin();
+
+// Draws the whole line, on the dot the FIFO would have finished it
+void ppu_line_render();
+
+// Before anything mode 3 reads changes: the rest of the line goes to the FIFO
+void ppu_line_fallback();
+
+const ppu_line_stats *ppu_line_get_stats();
+void ppu_line_print_stats();
+
 
 bool window_visible();
\ No newline at end of file
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <../headers/common.hpp>
+#include <string.h>
+
+// 2bpp tile data decoding: each tile row is two bitplane bytes (bit 7 is
+// the leftmost pixel), decoded to one color index (0 - 3) per pixel.
+
+typedef struct {
+    u8 spread[256][8];          // Bits of a byte, one per byte, bit 7 first
+    u8 reverse[256];            // Bit-reversed byte, for x-flipped rows
+} ppu_decode_tables;
+
+extern const ppu_decode_tables ppu_decode_lut;
+
+// One row into 8 color indexes, left to right
+static inline void ppu_decode_row(u8 lo, u8 hi, u8 *out) {
+    u64 a, b;
+
+    memcpy(&a, ppu_decode_lut.spread[lo], 8);
+    memcpy(&b, ppu_decode_lut.spread[hi], 8);
+
+    // Every byte is 0 or 1, so the shift stays inside it
+    a |= b << 1;
+    memcpy(out, &a, 8);
+}
+
+// `rows` rows as laid out in VRAM (lo, hi pairs) into 8 indexes per row in
+// `out`, and mirrored in `flipped`. Uses AVX2 or SSE2 when the CPU has them.
+void ppu_decode_rows(const u8 *data, u32 rows, u8 *out, u8 *flipped);
+
+// Kernel ppu_decode_rows() picked: "avx2", "sse2" or "scalar"
+const char *ppu_decode_kernel();
+
+typedef void (*ppu_decode_fn)(const u8 *data, u32 rows, u8 *out, u8 *flipped);
+
+typedef struct {
+    ppu_decode_fn fn;
+    const char *name;
+} ppu_decode_impl;
+
+// Every kernel this build has and the CPU can run, scalar first. For the
+// decode bench (bench/decode_bench.cpp).
+const ppu_decode_impl *ppu_decode_kernels(u32 *count);
@@ -2,6 +2,11 @@
 
 #include <../headers/common.hpp>
 
+typedef struct {
+    u8 wram[0x2000];
+    u8 hram[0x80];
+} ram_context;
+
 u8 wram_read(u16 address);
 void wram_write(u16 address, u8 value);
 
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <../headers/common.hpp>
+
+// Event scheduler for the components that run behind the CPU (see emu_sync()).
+// Each one posts the T-cycle of its next event: a TIMA overflow, the next
+// PPU mode change (VBlank being the frame end), or the end of the OAM DMA
+// lockout (the copy itself happens at once). Time jumps straight to the
+// earliest one, and only the M-cycle it falls in is ticked. When an event
+// fires, its component posts the next one.
+
+typedef enum {
+    SCHED_TIMER,
+    SCHED_PPU,
+    SCHED_DMA,
+    SCHED_EVENT_COUNT
+} sched_event;
+
+typedef struct {
+    u64 posted[SCHED_EVENT_COUNT];
+    u64 fired[SCHED_EVENT_COUNT];
+    u32 max_depth;
+} sched_stats;
+
+typedef struct {
+    u64 when;                           // Last idle tick, fires once now passes it
+    sched_event ev;
+} sched_entry;
+
+typedef struct {
+    u64 now;
+    sched_entry heap[SCHED_EVENT_COUNT];
+    int pos[SCHED_EVENT_COUNT];         // Index in heap, -1 when not queued
+    u32 size;
+    sched_stats stats;
+} sched_context;
+
+// Empties the queue and has every component post its event. The clock keeps
+// going, the timer counts from it.
+void sched_init();
+
+// T-cycle the timer, PPU and DMA have reached
+u64 sched_now();
+
+// Moves the clock, the components were ticked or skipped by `ticks`
+void sched_advance(u32 ticks);
+
+// `ev` happens after `idle_ticks` ticks that do nothing, replaces a queued `ev`
+void sched_post(sched_event ev, u32 idle_ticks);
+void sched_cancel(sched_event ev);
+
+// Has every component post its event again, after a register write that can
+// move it (TAC, DIV, LCDC, DMA start...)
+void sched_post_all();
+
+// Fires the events the clock went past, their components post the next ones
+void sched_dispatch();
+
+// Ticks before the earliest event, UINT32_MAX with an empty queue
+u32 sched_idle_ticks();
+
+u32 sched_depth();
+const sched_stats *sched_get_stats();
+void sched_print_stats();
@@ -7,12 +7,22 @@ typedef struct {
     u8 tima;
     u8 tma;
     u8 tac;
+
+    u64 base;                   // Scheduler tick the registers are as of
 } timer_context;
 
+// DIV and TIMA follow the scheduler clock (sched_now()) on their own, there
+// is no per-tick update
 void timer_init();
-void timer_tick();
+
+// T-cycles before TIMA overflows
+u32 timer_idle_ticks();
+
+// Posts the next TIMA overflow to the scheduler, the event also lands here
+void timer_schedule();
 
 void timer_write(u16 address, u8 value);
 u8 timer_read(u16 address);
 
+// Registers as of the scheduler clock
 timer_context *timer_get_context();
@@ -10,7 +10,9 @@ static const int SCREEN_WIDTH = 1024;
 static const int SCREEN_HEIGHT = 768;
 
 void ui_init(std::string);
-void ui_handle_events();
+
+// Sleeps until there's input or a new frame, handles it and redraws if needed
+void ui_wait_events();
 void ui_update();
 
 std::string rom_picker_sdl2(SDL_Window *window, SDL_Renderer *renderer, const std::string &directory);
\ No newline at end of file
@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../headers/main.hpp"
+#include "../headers/gameboy.hpp"
+#include "../headers/cart.hpp"
+#include "../headers/cpu.hpp"
+#include "../headers/cpu_idle.hpp"
+#include "../headers/ppu.hpp"
+#include "../headers/pacing.hpp"
+#include "../headers/dbg.hpp"
+#include "session.hpp"
+
+#include <pthread.h>
+#include <unistd.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+/*
+  Batch runner: runs every job of a manifest on a pool of worker threads,
+  one emulator instance per worker reused from job to job, and streams one
+  JSON line per finished job.
+
+  emu_batch <manifest> [options]
+    -j N                worker threads (default: online CPUs)
+    -o <file|->         JSONL results (default: -)
+    --core interp|threaded|dynarec
+    --no-idle-skip
+    --verbose           keep the emulator's own console output
+
+  Manifest: one "<rom> <frames> [input script]" per line, # comments.
+
+  Jobs are dealt round-robin to per-worker queues. A worker takes from the
+  back of its own queue and, once that is empty, steals from the front of
+  the others, so a few long ROMs don't leave the other cores idle.
+*/
+
+#define BATCH_MAX_WORKERS 256
+
+typedef struct {
+    std::string rom;
+    std::string input;
+    u64 frames;
+} batch_job;
+
+typedef struct {
+    pthread_mutex_t lock;
+    std::deque<u32> jobs;       // Manifest indexes
+} batch_queue;
+
+typedef struct {
+    u32 id;
+
+    u32 jobs;
+    u32 steals;
+    u64 frames;
+    u64 busy_ns;
+} batch_worker;
+
+typedef struct {
+    std::vector<batch_job> jobs;
+
+    batch_queue queues[BATCH_MAX_WORKERS];
+    batch_worker workers[BATCH_MAX_WORKERS];
+    u32 worker_count;
+
+    cpu_core core;
+    bool idle_skip;
+
+    pthread_mutex_t out_lock;
+    FILE *out;
+    u32 failed;
+} batch_context;
+
+static batch_context ctx;
+
+static bool load_manifest(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        fprintf(stderr, "Failed to open manifest: %s\n", path);
+        return false;
+    }
+
+    char line[4096];
+    int line_no = 0;
+
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+
+        char rom[2048];
+        char input[2048] = {0};
+        unsigned long long frames;
+
+        // Blank lines and # comments
+        if (line[strspn(line, " \t\r\n")] == 0 || line[strspn(line, " \t")] == '#') {
+            continue;
+        }
+
+        if (sscanf(line, "%2047s %llu %2047s", rom, &frames, input) < 2 || !frames) {
+            fprintf(stderr, "%s:%d: expected \"<rom> <frames> [input script]\"\n", path, line_no);
+            fclose(fp);
+            return false;
+        }
+
+        ctx.jobs.push_back({rom, input, frames});
+    }
+
+    fclose(fp);
+    return true;
+}
+
+// Own queue from the back, then the others from the front
+static bool take_job(batch_worker *w, u32 *job) {
+    for (u32 i = 0; i < ctx.worker_count; i++) {
+        u32 victim = (w->id + i) % ctx.worker_count;
+        batch_queue *q = &ctx.queues[victim];
+        bool found = false;
+
+        pthread_mutex_lock(&q->lock);
+
+        if (!q->jobs.empty()) {
+            if (victim == w->id) {
+                *job = q->jobs.back();
+                q->jobs.pop_back();
+            } else {
+                *job = q->jobs.front();
+                q->jobs.pop_front();
+            }
+
+            found = true;
+        }
+
+        pthread_mutex_unlock(&q->lock);
+
+        if (found) {
+            w->steals += victim != w->id;
+            return true;
+        }
+    }
+
+    // Nothing queues jobs once the workers run, so empty means done
+    return false;
+}
+
+// JSON string body, bytes outside printable ASCII as \u00XX
+static std::string json_escape(const char *s, size_t n) {
+    std::string r;
+
+    for (size_t i = 0; i < n; i++) {
+        u8 c = s[i];
+
+        if (c == '"' || c == '\\') {
+            r += '\\';
+            r += c;
+        } else if (c < 0x20 || c >= 0x7F) {
+            char esc[8];
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            r += esc;
+        } else {
+            r += c;
+        }
+    }
+
+    return r;
+}
+
+static std::string json_escape(const std::string &s) {
+    return json_escape(s.c_str(), s.size());
+}
+
+static void write_result(u32 index, batch_worker *w, const char *status, const std::string &error,
+                         const session_result *result, u64 hash) {
+    const batch_job *job = &ctx.jobs[index];
+    std::string line;
+    char buf[256];
+
+    snprintf(buf, sizeof(buf), "{\"job\":%u,\"worker\":%u,", index, w->id);
+    line += buf;
+    line += "\"rom\":\"" + json_escape(job->rom) + "\",";
+    line += "\"input\":\"" + json_escape(job->input) + "\",";
+    snprintf(buf, sizeof(buf), "\"frames\":%llu,\"status\":\"%s\"", (unsigned long long)job->frames, status);
+    line += buf;
+
+    if (!result) {
+        line += ",\"error\":\"" + json_escape(error) + "\"}";
+    } else {
+        double seconds = result->elapsed_ns / 1e9;
+
+        snprintf(buf, sizeof(buf), ",\"hash\":\"%016llx\",\"cycles\":%llu,\"seconds\":%.6f,\"fps\":%.1f,",
+            (unsigned long long)hash, (unsigned long long)result->ticks, seconds,
+            seconds > 0 ? result->frames / seconds : 0.0);
+        line += buf;
+        line += "\"serial\":\"" + json_escape(dbg_get_serial(), dbg_get_serial_size()) + "\"}";
+    }
+
+    pthread_mutex_lock(&ctx.out_lock);
+
+    fprintf(ctx.out, "%s\n", line.c_str());
+    fflush(ctx.out);
+
+    if (!result) {
+        ctx.failed++;
+    }
+
+    pthread_mutex_unlock(&ctx.out_lock);
+}
+
+static void run_job(batch_worker *w, u32 index) {
+    const batch_job *job = &ctx.jobs[index];
+    std::vector<input_event> events;
+    std::string error;
+
+    if (!job->input.empty() && !session_load_input(job->input.c_str(), events, error)) {
+        write_result(index, w, "error", error, nullptr, 0);
+        return;
+    }
+
+    if (!cart_load((char *)job->rom.c_str())) {
+        write_result(index, w, "error", "failed to load ROM", nullptr, 0);
+        return;
+    }
+
+    emu_init();
+
+    session_options options = {job->frames, 0, &events};
+    session_result result = session_run(&options);
+
+    w->jobs++;
+    w->frames += result.frames;
+    w->busy_ns += result.elapsed_ns;
+
+    write_result(index, w, result.stopped ? "stopped" : "ok", error, &result,
+        session_hash(ppu_frame_acquire()));
+}
+
+static void *worker_run(void *p) {
+    batch_worker *w = (batch_worker *)p;
+
+    // One instance for every job this worker runs, emu_init() resets it
+    gameboy *instance = gb_create();
+    gb_bind(instance);
+
+    cpu_set_core(ctx.core);
+    cpu_idle_set_enabled(ctx.idle_skip);
+
+    u32 index;
+    while (take_job(w, &index)) {
+        run_job(w, index);
+    }
+
+    gb_destroy(instance);
+    return 0;
+}
+
+static void usage(const char *name) {
+    fprintf(stderr, "Usage: %s <manifest> [-j N] [-o file|-] [--core interp|threaded|dynarec]\n"
+                    "       [--no-idle-skip] [--verbose]\n", name);
+}
+
+int main(int argc, char **argv) {
+    const char *manifest = NULL;
+    const char *out_path = "-";
+    long workers = sysconf(_SC_NPROCESSORS_ONLN);
+    bool verbose = false;
+
+    ctx.core = CORE_INTERP;
+    ctx.idle_skip = true;
+
+    for (int i = 1; i < argc; i++) {
+        bool has_arg = i + 1 < argc;
+
+        if (!strcmp(argv[i], "-j") && has_arg) {
+            workers = atol(argv[++i]);
+        } else if (!strcmp(argv[i], "-o") && has_arg) {
+            out_path = argv[++i];
+        } else if (!strcmp(argv[i], "--verbose")) {
+            verbose = true;
+        } else if (!strcmp(argv[i], "--no-idle-skip")) {
+            ctx.idle_skip = false;
+        } else if (!strcmp(argv[i], "--core") && has_arg) {
+            const char *name = argv[++i];
+
+            if (!strcmp(name, "threaded")) {
+                ctx.core = CORE_THREADED;
+            } else if (!strcmp(name, "dynarec")) {
+                ctx.core = CORE_DYNAREC;
+            } else if (!strcmp(name, "interp")) {
+                ctx.core = CORE_INTERP;
+            } else {
+                fprintf(stderr, "Unknown core: %s (expected interp, threaded or dynarec)\n", name);
+                return 1;
+            }
+        } else if (argv[i][0] != '-' && !manifest) {
+            manifest = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!manifest) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!load_manifest(manifest)) {
+        return 1;
+    }
+
+    if (workers < 1) {
+        workers = 1;
+    } else if (workers > BATCH_MAX_WORKERS) {
+        workers = BATCH_MAX_WORKERS;
+    }
+
+    if (ctx.jobs.size() && (size_t)workers > ctx.jobs.size()) {
+        workers = ctx.jobs.size();
+    }
+
+    ctx.worker_count = workers;
+
+    // Results keep the real stdout, the core's console output goes away
+    ctx.out = !strcmp(out_path, "-") ? fdopen(dup(fileno(stdout)), "w") : fopen(out_path, "w");
+    if (!ctx.out) {
+        fprintf(stderr, "Failed to open %s\n", out_path);
+        return 1;
+    }
+
+    if (!verbose && !freopen("/dev/null", "w", stdout)) {
+        fprintf(stderr, "Failed to silence stdout\n");
+    }
+
+    pthread_mutex_init(&ctx.out_lock, NULL);
+
+    for (u32 i = 0; i < ctx.worker_count; i++) {
+        pthread_mutex_init(&ctx.queues[i].lock, NULL);
+        ctx.workers[i].id = i;
+    }
+
+    for (u32 i = 0; i < ctx.jobs.size(); i++) {
+        ctx.queues[i % ctx.worker_count].jobs.push_back(i);
+    }
+
+    pthread_t threads[BATCH_MAX_WORKERS];
+    u64 start = pacing_now_ns();
+
+    for (u32 i = 0; i < ctx.worker_count; i++) {
+        if (pthread_create(&threads[i], NULL, worker_run, &ctx.workers[i])) {
+            fprintf(stderr, "Failed to start worker %u\n", i);
+            return 1;
+        }
+    }
+
+    for (u32 i = 0; i < ctx.worker_count; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    double seconds = (pacing_now_ns() - start) / 1e9;
+    u64 frames = 0;
+    u64 busy_ns = 0;
+    u32 steals = 0;
+
+    for (u32 i = 0; i < ctx.worker_count; i++) {
+        frames += ctx.workers[i].frames;
+        busy_ns += ctx.workers[i].busy_ns;
+        steals += ctx.workers[i].steals;
+    }
+
+    fclose(ctx.out);
+
+    fprintf(stderr, "Jobs: %zu (%u failed) on %u workers, %u stolen\n",
+        ctx.jobs.size(), ctx.failed, ctx.worker_count, steals);
+    fprintf(stderr, "Frames: %llu in %.3f s: %.1f fps aggregate, %.1f fps per busy worker\n",
+        (unsigned long long)frames, seconds,
+        seconds > 0 ? frames / seconds : 0.0,
+        busy_ns ? frames / (busy_ns / 1e9) : 0.0);
+
+    return ctx.failed ? 2 : 0;
+}
@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../headers/main.hpp"
+#include "../headers/gameboy.hpp"
+#include "../headers/cart.hpp"
+#include "../headers/cpu.hpp"
+#include "../headers/cpu_idle.hpp"
+#include "../headers/ppu.hpp"
+#include "../headers/scheduler.hpp"
+#include "../headers/pacing.hpp"
+#include "../headers/dbg.hpp"
+#include "session.hpp"
+
+/*
+  Headless runner: no window, no ROM picker and no frame pacing, the core
+  runs as fast as it can. Links the core sources only (no ui.cpp, no SDL).
+
+  emu_headless <rom> [options]
+    --frames N          stop once the PPU has finished N frames
+    --cycles N          stop after N clock cycles (T-cycles, 4.194304 MHz)
+    --input <file>      input script, one "<frame> <buttons>" per line,
+                        buttons: a,b,start,select,up,down,left,right or none
+    --ppm <file>        write the final frame as a binary PPM
+    --serial <file|->   write the serial port output
+    --hash              print a hash of the final frame and CPU state
+    --stats             print timing, idle skip, scheduler and renderer stats
+    --core interp|threaded|dynarec
+    --no-idle-skip
+    --no-scanline       draw every line with the pixel FIFO
+*/
+
+// Default run when neither --frames nor --cycles is given, 10 emulated seconds
+#define HEADLESS_DEFAULT_FRAMES 600
+
+static bool write_ppm(const char *path, const u32 *frame) {
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        printf("Failed to open %s\n", path);
+        return false;
+    }
+
+    fprintf(fp, "P6\n%d %d\n255\n", XRES, YRES);
+
+    // ARGB8888 to RGB
+    for (int i = 0; i < XRES * YRES; i++) {
+        u8 rgb[3] = {(u8)(frame[i] >> 16), (u8)(frame[i] >> 8), (u8)frame[i]};
+        fwrite(rgb, 1, 3, fp);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+static bool write_serial(const char *path) {
+    if (!strcmp(path, "-")) {
+        fwrite(dbg_get_serial(), 1, dbg_get_serial_size(), stdout);
+        return true;
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        printf("Failed to open %s\n", path);
+        return false;
+    }
+
+    fwrite(dbg_get_serial(), 1, dbg_get_serial_size(), fp);
+    fclose(fp);
+    return true;
+}
+
+static void usage(const char *name) {
+    printf("Usage: %s <rom> [--frames N | --cycles N] [--input file] [--ppm file]\n"
+           "       [--serial file|-] [--hash] [--stats] [--core interp|threaded|dynarec]\n"
+           "       [--no-idle-skip] [--no-scanline]\n", name);
+}
+
+int main(int argc, char **argv) {
+    const char *rom = NULL;
+    const char *input_path = NULL;
+    const char *ppm_path = NULL;
+    const char *serial_path = NULL;
+    u64 max_frames = 0;
+    u64 max_ticks = 0;
+    bool hash = false;
+    bool stats = false;
+
+    gb_bind(gb_create());
+
+    for (int i = 1; i < argc; i++) {
+        bool has_arg = i + 1 < argc;
+
+        if (!strcmp(argv[i], "--frames") && has_arg) {
+            max_frames = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--cycles") && has_arg) {
+            max_ticks = strtoull(argv[++i], NULL, 10);
+        } else if (!strcmp(argv[i], "--input") && has_arg) {
+            input_path = argv[++i];
+        } else if (!strcmp(argv[i], "--ppm") && has_arg) {
+            ppm_path = argv[++i];
+        } else if (!strcmp(argv[i], "--serial") && has_arg) {
+            serial_path = argv[++i];
+        } else if (!strcmp(argv[i], "--hash")) {
+            hash = true;
+        } else if (!strcmp(argv[i], "--stats")) {
+            stats = true;
+        } else if (!strcmp(argv[i], "--no-idle-skip")) {
+            cpu_idle_set_enabled(false);
+        } else if (!strcmp(argv[i], "--no-scanline")) {
+            ppu_line_set_enabled(false);
+        } else if (!strcmp(argv[i], "--core") && has_arg) {
+            const char *name = argv[++i];
+
+            if (!strcmp(name, "threaded")) {
+                cpu_set_core(CORE_THREADED);
+            } else if (!strcmp(name, "dynarec")) {
+                cpu_set_core(CORE_DYNAREC);
+            } else if (!strcmp(name, "interp")) {
+                cpu_set_core(CORE_INTERP);
+            } else {
+                printf("Unknown core: %s (expected interp, threaded or dynarec)\n", name);
+                return 1;
+            }
+        } else if (argv[i][0] != '-' && !rom) {
+            rom = argv[i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (!rom) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    if (!max_frames && !max_ticks) {
+        max_frames = HEADLESS_DEFAULT_FRAMES;
+    }
+
+    std::vector<input_event> events;
+    std::string error;
+
+    if (input_path && !session_load_input(input_path, events, error)) {
+        printf("%s\n", error.c_str());
+        return 1;
+    }
+
+    if (!cart_load((char *)rom)) {
+        printf("Failed to load ROM!\n");
+        return 1;
+    }
+
+    emu_init();
+
+    session_options options = {max_frames, max_ticks, &events};
+    session_result result = session_run(&options);
+
+    if (result.stopped) {
+        printf("CPU Stopped\n");
+    }
+
+    const u32 *pixels = ppu_frame_acquire();
+
+    if (ppm_path && !write_ppm(ppm_path, pixels)) {
+        return 1;
+    }
+
+    if (serial_path && !write_serial(serial_path)) {
+        return 1;
+    }
+
+    if (hash) {
+        printf("Hash: %016llx\n", (unsigned long long)session_hash(pixels));
+    }
+
+    if (stats) {
+        double seconds = result.elapsed_ns / 1e9;
+        double emulated = (double)result.ticks / PACING_CLOCK_HZ;
+
+        printf("Frames: %u\n", result.frames);
+        printf("Cycles: %llu\n", (unsigned long long)result.ticks);
+        printf("Time: %.3f s\n", seconds);
+        printf("Speed: %.1f fps, %.2fx realtime\n",
+            seconds > 0 ? result.frames / seconds : 0.0,
+            seconds > 0 ? emulated / seconds : 0.0);
+
+        cpu_idle_print_stats();
+        sched_print_stats();
+        ppu_line_print_stats();
+    }
+
+    return result.stopped ? 2 : 0;
+}
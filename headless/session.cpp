@@ -0,0 +1,174 @@
+#include "session.hpp"
+#include "../headers/main.hpp"
+#include "../headers/gameboy.hpp"
+#include "../headers/pacing.hpp"
+
+#include <string.h>
+#include <string>
+
+#define FNV_OFFSET 1469598103934665603ULL
+#define FNV_PRIME  1099511628211ULL
+
+// Longest instruction, the cycle target switches to single steps this close
+#define SESSION_MAX_INST_TICKS 24
+
+static bool parse_buttons(const char *list, gamepad_state *state) {
+    memset(state, 0, sizeof(*state));
+
+    if (!strcmp(list, "none")) {
+        return true;
+    }
+
+    std::string names(list);
+    size_t start = 0;
+
+    while (start <= names.size()) {
+        size_t end = names.find(',', start);
+        if (end == std::string::npos) {
+            end = names.size();
+        }
+
+        std::string name = names.substr(start, end - start);
+
+        if (name == "a") {
+            state->a = true;
+        } else if (name == "b") {
+            state->b = true;
+        } else if (name == "start") {
+            state->start = true;
+        } else if (name == "select") {
+            state->select = true;
+        } else if (name == "up") {
+            state->up = true;
+        } else if (name == "down") {
+            state->down = true;
+        } else if (name == "left") {
+            state->left = true;
+        } else if (name == "right") {
+            state->right = true;
+        } else {
+            return false;
+        }
+
+        start = end + 1;
+    }
+
+    return true;
+}
+
+bool session_load_input(const char *path, std::vector<input_event> &events, std::string &error) {
+    FILE *fp = fopen(path, "r");
+    if (!fp) {
+        error = std::string("failed to open input script ") + path;
+        return false;
+    }
+
+    char line[256];
+    int line_no = 0;
+
+    events.clear();
+
+    while (fgets(line, sizeof(line), fp)) {
+        line_no++;
+
+        char buttons[200];
+        input_event ev;
+
+        // Blank lines and # comments
+        if (line[strspn(line, " \t\r\n")] == 0 || line[strspn(line, " \t")] == '#') {
+            continue;
+        }
+
+        const char *problem = nullptr;
+
+        if (sscanf(line, "%u %199s", &ev.frame, buttons) != 2 || !parse_buttons(buttons, &ev.state)) {
+            problem = "expected \"<frame> <buttons>\"";
+        } else if (!events.empty() && ev.frame < events.back().frame) {
+            problem = "frames must be in order";
+        }
+
+        if (problem) {
+            error = std::string(path) + ":" + std::to_string(line_no) + ": " + problem;
+            fclose(fp);
+            return false;
+        }
+
+        events.push_back(ev);
+    }
+
+    fclose(fp);
+    return true;
+}
+
+session_result session_run(const session_options *options) {
+    session_result result = {};
+
+    emu_context *ctx = emu_get_context();
+    ppu_context *ppu = ppu_get_context();
+    const std::vector<input_event> *input = options->input;
+    size_t next_event = 0;
+    u32 frame = ppu->current_frame;
+
+    // Frame 0 entries apply before the first instruction
+    while (input && next_event < input->size() && (*input)[next_event].frame <= frame) {
+        *gamepad_get_state() = (*input)[next_event++].state;
+    }
+
+    u64 start = pacing_now_ns();
+
+    while (true) {
+        if (options->frames && ppu->current_frame >= options->frames) {
+            break;
+        }
+
+        if (options->ticks && ctx->ticks >= options->ticks) {
+            break;
+        }
+
+        // Whole batches until the cycle target is close, then instruction by
+        // instruction so the run stops at the same place on every core
+        u32 steps = CPU_EXEC_BATCH;
+        if (options->ticks && options->ticks - ctx->ticks < CPU_EXEC_BATCH * SESSION_MAX_INST_TICKS) {
+            steps = 1;
+        }
+
+        if (!cpu_exec(steps)) {
+            result.stopped = true;
+            break;
+        }
+
+        if (frame != ppu->current_frame) {
+            frame = ppu->current_frame;
+
+            while (input && next_event < input->size() && (*input)[next_event].frame <= frame) {
+                *gamepad_get_state() = (*input)[next_event++].state;
+            }
+        }
+    }
+
+    result.elapsed_ns = pacing_now_ns() - start;
+    result.frames = ppu->current_frame;
+    result.ticks = ctx->ticks;
+
+    return result;
+}
+
+static void hash_bytes(u64 *h, const void *p, size_t n) {
+    const u8 *b = (const u8 *)p;
+
+    for (size_t i = 0; i < n; i++) {
+        *h = (*h ^ b[i]) * FNV_PRIME;
+    }
+}
+
+u64 session_hash(const u32 *frame) {
+    u64 h = FNV_OFFSET;
+    cpu_regs *regs = cpu_get_regs();
+    u64 ticks = emu_get_context()->ticks;
+
+    hash_bytes(&h, frame, XRES * YRES * sizeof(u32));
+    hash_bytes(&h, regs, sizeof(*regs));
+    hash_bytes(&h, &ticks, sizeof(ticks));
+
+    return h;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../headers/common.hpp"
+#include "../headers/gamepad.hpp"
+
+#include <string>
+#include <vector>
+
+// One headless run of the instance bound to the calling thread: input
+// script, stop conditions and the state hash, shared by emu_headless and
+// emu_batch.
+
+typedef struct {
+    u32 frame;
+    gamepad_state state;
+} input_event;
+
+typedef struct {
+    u64 frames;                             // Stop once the PPU finished this many, 0 for no limit
+    u64 ticks;                              // Stop after this many T-cycles, 0 for no limit
+    const std::vector<input_event> *input;  // Sorted by frame, may be nullptr
+} session_options;
+
+typedef struct {
+    bool stopped;                           // cpu_exec() gave up before a limit
+    u32 frames;
+    u64 ticks;
+    u64 elapsed_ns;
+} session_result;
+
+// One "<frame> <buttons>" per line, buttons a,b,start,select,up,down,left,right
+// comma-separated or "none". Blank lines and # comments are skipped. Errors
+// are reported into `error`.
+bool session_load_input(const char *path, std::vector<input_event> &events, std::string &error);
+
+// Runs the loaded cart from emu_init() until a limit, as fast as it goes
+session_result session_run(const session_options *options);
+
+// FNV-1a over the frame, the registers and the clock
+u64 session_hash(const u32 *frame);
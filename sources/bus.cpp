@@ -5,6 +5,7 @@
 #include <../headers/io.hpp>
 #include <../headers/dma.hpp>
 #include <../headers/ppu.hpp>
+#include <../headers/main.hpp>
 #include <stdexcept>
 
 // 0x0000 - 0x3FFF : ROM Bank 0
@@ -21,8 +22,20 @@
 // 0xFF00 - 0xFF7F : I/O Registers
 // 0xFF80 - 0xFFFE : Zero Page
 
+// VRAM, OAM and the timer, IF, LCD and DMA registers belong to components
+// that run behind the CPU (see emu_sync()). Nothing else changes under it:
+// ROM, RAM, HRAM, the joypad and serial ports.
+static inline bool bus_synced(u16 address) {
+    return BETWEEN(address, 0x8000, 0x9FFF) || BETWEEN(address, 0xFE00, 0xFEFF) ||
+        BETWEEN(address, 0xFF04, 0xFF0F) || BETWEEN(address, 0xFF40, 0xFF4B);
+}
+
 u8 bus_read(u16 address){
 
+    if (bus_synced(address)) {
+        emu_sync();
+    }
+
     if (address < 0x8000){
 
         return cart_read(address);          // Reading from ROM
@@ -76,6 +89,10 @@ void bus_write(u16 address, u8 value) {
         return;
     }
 
+    if (bus_synced(address)) {
+        emu_sync();
+    }
+
     if (address < 0x8000) {
 
         cart_write(address, value);         // ROM Data
@@ -116,7 +133,10 @@ void bus_write(u16 address, u8 value) {
     } else if (address < 0xFF80) {
 
         io_write(address, value);           // IO Registers
-        
+
+        if (bus_synced(address)) {
+            emu_sync_invalidate();
+        }
 
     } else if (address == 0xFFFF) {
 
@@ -1,30 +1,30 @@
 #include <../headers/cart.hpp>
+#include <../headers/cpu_dynarec.hpp>
+#include <../headers/gameboy.hpp>
 #include <map>
 #include <string>
 #include <string.h>
 
 
-static cart_context ctx;
-
 cart_context *cart_get_context() {
-    return &ctx;
+    return &gb->cart;
 }
 
 bool cart_need_save(){
-    return ctx.need_save;
+    return gb->cart.need_save;
 }
 
 bool cart_mbc1(){
-    return BETWEEN(ctx.header->type, 0x01, 0x03);
+    return BETWEEN(gb->cart.header->type, 0x01, 0x03);
 }
 
 bool cart_mbc3() {
-    return (ctx.header->type >= 0x0F && ctx.header->type <= 0x13);
+    return (gb->cart.header->type >= 0x0F && gb->cart.header->type <= 0x13);
 }
 
 bool cart_battery() {
     // Only deal with MBC1
-    return ctx.header->type == 0x03;
+    return gb->cart.header->type == 0x03;
 }
 
 
@@ -132,8 +132,8 @@ static const std::map<u8, std::string> LIC_CODE = {
 };
 
 const char *cart_lic_name() {
-    if (ctx.header->new_lic_code <= 0xA4) {
-        auto it = LIC_CODE.find(ctx.header->lic_code);
+    if (gb->cart.header->new_lic_code <= 0xA4) {
+        auto it = LIC_CODE.find(gb->cart.header->lic_code);
         if (it != LIC_CODE.end()) {
             return it->second.c_str();
         }
@@ -143,8 +143,8 @@ const char *cart_lic_name() {
 }
 
 const char *cart_type_name() {
-    if (ctx.header->type <= 0x22) {
-        return ROM_TYPES[ctx.header->type];
+    if (gb->cart.header->type <= 0x22) {
+        return ROM_TYPES[gb->cart.header->type];
     }
 
     return "unkown type";
@@ -152,77 +152,94 @@ const char *cart_type_name() {
 
 void cart_setup_banking(){
     for (int i = 0 ; i < 16 ; i++){
-        ctx.ram_banks[i] = 0;
+        gb->cart.ram_banks[i] = 0;
 
         // Only has 1 bank if RAM size is 2
         // or 4 banks if RAM size is 3
-        if (ctx.header->ram_size == 2 && i == 0 ||
-            ctx.header->ram_size == 3 && i < 4  ||
-            ctx.header->ram_size == 4 && i < 16 ||
-            ctx.header->ram_size == 5 && i < 8) {
+        if (gb->cart.header->ram_size == 2 && i == 0 ||
+            gb->cart.header->ram_size == 3 && i < 4  ||
+            gb->cart.header->ram_size == 4 && i < 16 ||
+            gb->cart.header->ram_size == 5 && i < 8) {
 
-            ctx.ram_banks[i] = new u8[0x2000];      // 8KB
-            memset(ctx.ram_banks[i], 0, 0x2000);
+            gb->cart.ram_banks[i] = new u8[0x2000];      // 8KB
+            memset(gb->cart.ram_banks[i], 0, 0x2000);
         }
     }
 
-    ctx.ram_bank = ctx.ram_banks[0];
-    ctx.rom_bank_x = ctx.rom_data + 0x4000;         // 16KB ROM bank 1
+    gb->cart.ram_bank = gb->cart.ram_banks[0];
+    gb->cart.rom_bank_x = gb->cart.rom_data + 0x4000;         // 16KB ROM bank 1
+
+}
+
+void cart_unload() {
+    for (int i = 0 ; i < 16 ; i++){
+        delete[] gb->cart.ram_banks[i];
+        gb->cart.ram_banks[i] = 0;
+    }
 
+    delete[] gb->cart.rom_data;
+    gb->cart.rom_data = 0;
+    gb->cart.ram_bank = 0;
+    gb->cart.rom_bank_x = 0;
 }
 
 bool cart_load(char *cart) {
-    
-    snprintf(ctx.filename, sizeof(ctx.filename), "%s", cart);
+    // Instances are reused from one ROM to the next: nothing of the previous
+    // cart's MBC state survives, ROM bank 1 is mapped and RAM disabled
+    cart_unload();
+    memset(&gb->cart, 0, sizeof(gb->cart));
+    gb->cart.rom_bank_value = 1;
+
+    snprintf(gb->cart.filename, sizeof(gb->cart.filename), "%s", cart);
 
     FILE *fp = fopen(cart, "rb");
     if (!fp) {printf("Failed to open: %s\n", cart); return false;}
 
-    printf("Opened: %s\n", ctx.filename);
+    printf("Opened: %s\n", gb->cart.filename);
 
     // Get file size
     fseek(fp, 0, SEEK_END);
-    ctx.rom_size = ftell(fp);
+    gb->cart.rom_size = ftell(fp);
 
     // Go back to start of file
     rewind(fp);
 
     // Allocate memory and read file
-    ctx.rom_data = new u8[ctx.rom_size];
-    memset(ctx.rom_data, 0, ctx.rom_size);
+    gb->cart.rom_data = new u8[gb->cart.rom_size];
+    memset(gb->cart.rom_data, 0, gb->cart.rom_size);
     
-    fread(ctx.rom_data, ctx.rom_size, 1, fp);
+    fread(gb->cart.rom_data, gb->cart.rom_size, 1, fp);
     fclose(fp);
 
 
     // Get header and banking
-    ctx.header = (rom_header *)(ctx.rom_data + 0x100); // 0x100 is the start of the header in GB carts
-    ctx.header->title[15] = 0;
+    gb->cart.header = (rom_header *)(gb->cart.rom_data + 0x100); // 0x100 is the start of the header in GB carts
+    gb->cart.header->title[15] = 0;
 
-    ctx.battery = cart_battery();
-    ctx.need_save = false;
+    gb->cart.battery = cart_battery();
+    gb->cart.need_save = false;
 
     // Print info tabulated
     char type_str[32];
-    snprintf(type_str, sizeof(type_str), "%02X (%-17s)", ctx.header->type, cart_type_name());
+    snprintf(type_str, sizeof(type_str), "%02X (%-17s)", gb->cart.header->type, cart_type_name());
     
     char rom_size_str[32];
-    snprintf(rom_size_str, sizeof(rom_size_str), "%d KB", 32 << ctx.header->rom_size);
+    snprintf(rom_size_str, sizeof(rom_size_str), "%d KB", 32 << gb->cart.header->rom_size);
     
     char ram_size_str[32];
-    snprintf(ram_size_str, sizeof(ram_size_str), "0x%X", ctx.header->ram_size);
+    snprintf(ram_size_str, sizeof(ram_size_str), "0x%X", gb->cart.header->ram_size);
     
     char lic_str[32];
-    snprintf(lic_str, sizeof(lic_str), "%02X (%-17s)", ctx.header->lic_code, cart_lic_name());
+    snprintf(lic_str, sizeof(lic_str), "%02X (%-17s)", gb->cart.header->lic_code, cart_lic_name());
     
     char rom_ver_str[32];
-    snprintf(rom_ver_str, sizeof(rom_ver_str), "0x%X", ctx.header->version);
+    snprintf(rom_ver_str, sizeof(rom_ver_str), "0x%X", gb->cart.header->version);
     
     // Print info tabulated
     printf("===============================================\n");
     printf("| %-12s | %-25s |\n", "Field", "Value");
     printf("===============================================\n");
-    printf("| %-12s | %-25s |\n", "Title", ctx.header->title);
+    printf("| %-12s | %-25s |\n", "Title", gb->cart.header->title);
     printf("| %-12s | %-25s |\n", "Type", type_str);
     printf("| %-12s | %-25s |\n", "ROM Size", rom_size_str);
     printf("| %-12s | %-25s |\n", "RAM Size", ram_size_str);
@@ -237,12 +254,12 @@ bool cart_load(char *cart) {
     // Nintendo's checksum algorithm
     u16 x = 0;
     for (u16 i=0x0134; i<=0x014C; i++) {
-        x = x - ctx.rom_data[i] - 1;
+        x = x - gb->cart.rom_data[i] - 1;
     }
 
-    printf("\t Checksum : %2.2X (%s)\n", ctx.header->checksum, (x & 0xFF) ? "PASSED" : "FAILED");
+    printf("\t Checksum : %2.2X (%s)\n", gb->cart.header->checksum, (x & 0xFF) ? "PASSED" : "FAILED");
 
-    if (ctx.battery){
+    if (gb->cart.battery){
         cart_battery_load();
     }
 
@@ -252,17 +269,17 @@ bool cart_load(char *cart) {
 void cart_battery_load(){
     char fn[1048];
 
-    char *dot = strrchr(ctx.filename, '.');
+    char *dot = strrchr(gb->cart.filename, '.');
     if (dot) {
-        char *filename_only = strrchr(ctx.filename, '/');
-        if (!filename_only) filename_only = strrchr(ctx.filename, '\\');
-        filename_only = filename_only ? filename_only + 1 : ctx.filename;
+        char *filename_only = strrchr(gb->cart.filename, '/');
+        if (!filename_only) filename_only = strrchr(gb->cart.filename, '\\');
+        filename_only = filename_only ? filename_only + 1 : gb->cart.filename;
         
         snprintf(fn, sizeof(fn), "../roms/saves/%.*s.battery", (int)(dot - filename_only), filename_only);
     } else {
-        char *filename_only = strrchr(ctx.filename, '/');
-        if (!filename_only) filename_only = strrchr(ctx.filename, '\\');
-        filename_only = filename_only ? filename_only + 1 : ctx.filename;
+        char *filename_only = strrchr(gb->cart.filename, '/');
+        if (!filename_only) filename_only = strrchr(gb->cart.filename, '\\');
+        filename_only = filename_only ? filename_only + 1 : gb->cart.filename;
         
         snprintf(fn, sizeof(fn), "../roms/saves/%s.battery", filename_only);
     }
@@ -275,7 +292,7 @@ void cart_battery_load(){
         return;
     }
     
-    fread(ctx.ram_bank, 0x2000, 1, fp); // Save the current RAM bank
+    fread(gb->cart.ram_bank, 0x2000, 1, fp); // Save the current RAM bank
     fclose(fp);
 
 }
@@ -283,17 +300,17 @@ void cart_battery_load(){
 void cart_battery_save(){
     char fn[1048];
 
-    char *dot = strrchr(ctx.filename, '.');
+    char *dot = strrchr(gb->cart.filename, '.');
     if (dot) {
-        char *filename_only = strrchr(ctx.filename, '/');
-        if (!filename_only) filename_only = strrchr(ctx.filename, '\\');
-        filename_only = filename_only ? filename_only + 1 : ctx.filename;
+        char *filename_only = strrchr(gb->cart.filename, '/');
+        if (!filename_only) filename_only = strrchr(gb->cart.filename, '\\');
+        filename_only = filename_only ? filename_only + 1 : gb->cart.filename;
         
         snprintf(fn, sizeof(fn), "../roms/saves/%.*s.battery", (int)(dot - filename_only), filename_only);
     } else {
-        char *filename_only = strrchr(ctx.filename, '/');
-        if (!filename_only) filename_only = strrchr(ctx.filename, '\\');
-        filename_only = filename_only ? filename_only + 1 : ctx.filename;
+        char *filename_only = strrchr(gb->cart.filename, '/');
+        if (!filename_only) filename_only = strrchr(gb->cart.filename, '\\');
+        filename_only = filename_only ? filename_only + 1 : gb->cart.filename;
         
         snprintf(fn, sizeof(fn), "../roms/saves/%s.battery", filename_only);
     }
@@ -305,7 +322,7 @@ void cart_battery_save(){
         return;
     }
 
-    fwrite(ctx.ram_bank, 0x2000, 1, fp); // Save the current RAM bank
+    fwrite(gb->cart.ram_bank, 0x2000, 1, fp); // Save the current RAM bank
     fclose(fp);
 
 }
@@ -313,29 +330,29 @@ void cart_battery_save(){
 u8 cart_read(u16 address) {
     // Always support ROM bank 0 at 0x0000–0x3FFF
     if (address < 0x4000)
-        return ctx.rom_data[address];
+        return gb->cart.rom_data[address];
 
     // Cart MBC1
     if (cart_mbc1()) {
         if ((address & 0xE000) == 0xA000) {
-            if (!ctx.ram_enabled || !ctx.ram_bank) return 0xFF;
-            return ctx.ram_bank[address - 0xA000];
+            if (!gb->cart.ram_enabled || !gb->cart.ram_bank) return 0xFF;
+            return gb->cart.ram_bank[address - 0xA000];
         }
-        return ctx.rom_bank_x[address - 0x4000];
+        return gb->cart.rom_bank_x[address - 0x4000];
     }
 
     // Cart MBC3
     if (cart_mbc3()) {
         if ((address & 0xE000) == 0xA000) {
-            if (!ctx.ram_enabled || !ctx.ram_bank) return 0xFF;
-            return ctx.ram_bank[address - 0xA000];
+            if (!gb->cart.ram_enabled || !gb->cart.ram_bank) return 0xFF;
+            return gb->cart.ram_bank[address - 0xA000];
         }
-        return ctx.rom_bank_x[address - 0x4000];
+        return gb->cart.rom_bank_x[address - 0x4000];
     }
 
-    if (ctx.header->type == 0x00) { // ROM ONLY
-        if (address < ctx.rom_size)
-            return ctx.rom_data[address];
+    if (gb->cart.header->type == 0x00) { // ROM ONLY
+        if (address < gb->cart.rom_size)
+            return gb->cart.rom_data[address];
         else
             return 0xFF; // Out of bounds, open bus
     }
@@ -349,7 +366,7 @@ void cart_write(u16 address, u8 value) {
         // Cart MBC1
     if (cart_mbc1()){
         if (address < 0x2000){
-            ctx.ram_enabled = (value & 0x0F) == 0x0A; 
+            gb->cart.ram_enabled = (value & 0x0F) == 0x0A; 
         }
         
         if ((address & 0xE000) == 0x2000){
@@ -360,45 +377,46 @@ void cart_write(u16 address, u8 value) {
 
             value &= 0b11111;
 
-            ctx.rom_bank_value = value;
-            ctx.rom_bank_x = ctx.rom_data + (0x4000 * ctx.rom_bank_value);
+            gb->cart.rom_bank_value = value;
+            gb->cart.rom_bank_x = gb->cart.rom_data + (0x4000 * gb->cart.rom_bank_value);
+            cpu_dynarec_bank_switch();
         }
 
         if ((address & 0xE000) == 0x4000){
             // Ram Bank Number (2-bit register)
-            ctx.ram_bank_value = value & 0b11;
+            gb->cart.ram_bank_value = value & 0b11;
         
-            if (ctx.ram_banking){
+            if (gb->cart.ram_banking){
                 if (cart_need_save()){cart_battery_save();}
-                ctx.ram_bank = ctx.ram_banks[ctx.ram_bank_value];
+                gb->cart.ram_bank = gb->cart.ram_banks[gb->cart.ram_bank_value];
             }
         }
 
         if ((address & 0xE000) == 0x6000){
             // Banking Mode Selection (1-bit register)
-            ctx.banking_mode = value & 1; 
+            gb->cart.banking_mode = value & 1; 
 
-            ctx.ram_banking = ctx.banking_mode;
+            gb->cart.ram_banking = gb->cart.banking_mode;
             
-            if (ctx.ram_banking){
-                ctx.ram_bank = ctx.ram_banks[ctx.ram_bank_value];
+            if (gb->cart.ram_banking){
+                gb->cart.ram_bank = gb->cart.ram_banks[gb->cart.ram_bank_value];
             }
         }
 
         if ((address & 0xE000) == 0xA000){
             
-            if (!ctx.ram_enabled){
+            if (!gb->cart.ram_enabled){
                 return;
             }
             
-            if (!ctx.ram_bank) {
+            if (!gb->cart.ram_bank) {
                 return;
             }
 
-            ctx.ram_bank[(address - 0xA000)] = value;
+            gb->cart.ram_bank[(address - 0xA000)] = value;
         
-            if (ctx.battery) {
-                ctx.need_save = true; // We need to save the battery
+            if (gb->cart.battery) {
+                gb->cart.need_save = true; // We need to save the battery
                 }
             }
     }
@@ -407,36 +425,37 @@ void cart_write(u16 address, u8 value) {
     if (cart_mbc3()) {
         // RAM enable
         if (address < 0x2000) {
-            ctx.ram_enabled = ((value & 0x0F) == 0x0A);
+            gb->cart.ram_enabled = ((value & 0x0F) == 0x0A);
             return;
         }
         // ROM bank number (7 bits, never 0)
         if (address >= 0x2000 && address < 0x4000) {
             u8 bank = value & 0x7F;
             if (bank == 0) bank = 1;
-            ctx.rom_bank_value = bank;
-            ctx.rom_bank_x = ctx.rom_data + (0x4000 * ctx.rom_bank_value);
+            gb->cart.rom_bank_value = bank;
+            gb->cart.rom_bank_x = gb->cart.rom_data + (0x4000 * gb->cart.rom_bank_value);
+            cpu_dynarec_bank_switch();
             return;
         }
         // RAM bank number (2 bits, 0–3)
         if (address >= 0x4000 && address < 0x6000) {
-            ctx.ram_bank_value = value & 0x03;
-            ctx.ram_bank = ctx.ram_banks[ctx.ram_bank_value];
+            gb->cart.ram_bank_value = value & 0x03;
+            gb->cart.ram_bank = gb->cart.ram_banks[gb->cart.ram_bank_value];
             // RTC select ignored (value 0x08–0x0C) for now
             return;
         }
         // Latch clock (RTC) is not implemented, ignore 0x6000–0x7FFF
         // RAM write
         if ((address & 0xE000) == 0xA000) {
-            if (!ctx.ram_enabled || !ctx.ram_bank) return;
-            ctx.ram_bank[address - 0xA000] = value;
-            if (ctx.battery) ctx.need_save = true;
+            if (!gb->cart.ram_enabled || !gb->cart.ram_bank) return;
+            gb->cart.ram_bank[address - 0xA000] = value;
+            if (gb->cart.battery) gb->cart.need_save = true;
             return;
         }
         return;
     }
 
-    if (ctx.header->type == 0x00) {
+    if (gb->cart.header->type == 0x00) {
         return;
     }
 }
\ No newline at end of file
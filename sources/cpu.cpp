@@ -5,78 +5,101 @@
 #include <./../headers/main.hpp>
 #include <./../headers/dbg.hpp>
 #include <./../headers/timer.hpp>
+#include <./../headers/cpu_cache.hpp>
+#include <./../headers/cpu_fetch.hpp>
+#include <./../headers/cpu_flags.hpp>
+#include <./../headers/cpu_threaded.hpp>
+#include <./../headers/cpu_dynarec.hpp>
+#include <./../headers/cpu_idle.hpp>
+#include <./../headers/gameboy.hpp>
 #include <unistd.h>
-
-cpu_context ctx = {0};
+#include <string.h>
 
 #define CPU_DEBUG 0
 
 void cpu_init() {
 
-    init_instructions();    
+    memset(&gb->cpu, 0, sizeof(gb->cpu));
+
+    cpu_cache_init();
+    cpu_idle_init();
+
+    // Blocks of the previous cart
+    cpu_dynarec_flush();
 
-    ctx.regs.pc = 0x100;
-    ctx.regs.sp = 0xFFFE;
-    *((short *)&ctx.regs.a) = 0xB001;
-    *((short *)&ctx.regs.b) = 0x1300;
-    *((short *)&ctx.regs.d) = 0xD800;
-    *((short *)&ctx.regs.h) = 0x4D01;
-    ctx.ie_register = 0;
-    ctx.int_flags = 0;
-    ctx.int_master_enabled = false;
-    ctx.enabling_ime = false;
+    gb->cpu.regs.pc = 0x100;
+    gb->cpu.regs.sp = 0xFFFE;
+    gb->cpu.regs.af = 0x01B0;
+    gb->cpu.regs.bc = 0x0013;
+    gb->cpu.regs.de = 0x00D8;
+    gb->cpu.regs.hl = 0x014D;
+    gb->cpu.ie_register = 0;
+    gb->cpu.int_flags = 0;
+    gb->cpu.int_master_enabled = false;
+    gb->cpu.enabling_ime = false;
 
     timer_get_context()->div = 0xABCC;
 }
 
 static void fetch_instruction() {
-    ctx.current_opcode = bus_read(ctx.regs.pc++);
-    ctx.current_inst = instruction_by_opcode(ctx.current_opcode);
-}
+    gb->cpu.decoded = cpu_cache_lookup(gb->cpu.regs.pc);
+
+    if (gb->cpu.decoded) {
+        gb->cpu.current_opcode = gb->cpu.decoded->opcode;
+        gb->cpu.current_inst = gb->cpu.decoded->inst;
+        gb->cpu.regs.pc++;
+        return;
+    }
 
-void fetch_data();
+    gb->cpu.current_opcode = bus_read(gb->cpu.regs.pc++);
+    gb->cpu.current_inst = instruction_by_opcode(gb->cpu.current_opcode);
+}
 
+#if CPU_DEBUG == 1
+// Generic path, the debug trace needs fetch_data() and the IN_PROC table
 static void execute() {
-    IN_PROC proc = inst_get_proc(ctx.current_inst->type);
+    IN_PROC proc = inst_get_proc(gb->cpu.current_inst->type);
 
     if (!proc) {
         NO_IMPL
     }
 
-    proc(&ctx);
+    proc(&gb->cpu);
 }
+#endif
 
 bool cpu_step() {
+    u16 pc = gb->cpu.regs.pc;
     
-    if (!ctx.halted) {
-        u16 pc = ctx.regs.pc;
-
+    if (!gb->cpu.halted) {
         fetch_instruction();
-        emu_cycles(1);
-        fetch_data();
+
+        // A cached entry already holds the immediates, so all fetch cycles go at once
+        emu_cycles(gb->cpu.decoded ? gb->cpu.decoded->length : 1);
 
 #if CPU_DEBUG == 1
+        fetch_data();
+
         char flags[16];
+        cpu_flags_sync(&gb->cpu);
         sprintf(flags, "%c%c%c%c", 
-            ctx.regs.f & (1 << 7) ? 'Z' : '-',
-            ctx.regs.f & (1 << 6) ? 'N' : '-',
-            ctx.regs.f & (1 << 5) ? 'H' : '-',
-            ctx.regs.f & (1 << 4) ? 'C' : '-'
+            gb->cpu.regs.f & (1 << 7) ? 'Z' : '-',
+            gb->cpu.regs.f & (1 << 6) ? 'N' : '-',
+            gb->cpu.regs.f & (1 << 5) ? 'H' : '-',
+            gb->cpu.regs.f & (1 << 4) ? 'C' : '-'
         );
 
         char inst[16];
-        inst_to_str(&ctx, inst);
+        inst_to_str(&gb->cpu, inst);
 
         printf("%08lX - %04X: %-12s (%02X %02X %02X) A: %02X F: %s BC: %02X%02X DE: %02X%02X HL: %02X%02X\n", 
             emu_get_context()->ticks,
-            pc, inst, ctx.current_opcode,
-            bus_read(pc + 1), bus_read(pc + 2), ctx.regs.a, flags, ctx.regs.b, ctx.regs.c,
-            ctx.regs.d, ctx.regs.e, ctx.regs.h, ctx.regs.l);
-
+            pc, inst, gb->cpu.current_opcode,
+            bus_read(pc + 1), bus_read(pc + 2), gb->cpu.regs.a, flags, gb->cpu.regs.b, gb->cpu.regs.c,
+            gb->cpu.regs.d, gb->cpu.regs.e, gb->cpu.regs.h, gb->cpu.regs.l);
 
-#endif
-        if (ctx.current_inst == nullptr) {
-            printf("Unknown Instruction! %02X\n", ctx.current_opcode);
+        if (gb->cpu.current_inst == nullptr) {
+            printf("Unknown Instruction! %02X\n", gb->cpu.current_opcode);
             exit(-7);
         }
 
@@ -84,35 +107,86 @@ bool cpu_step() {
         dbg_print();
 
         execute();
+#else
+        // Specialized handler: operand fetch, dbg_update() and execute
+        IN_PROC handler = gb->cpu.decoded ? gb->cpu.decoded->proc : cpu_op_handler(gb->cpu.current_opcode);
+        handler(&gb->cpu);
+#endif
     } else {
-        // CPU is halted
-        emu_cycles(1);
+        // CPU is halted, jump ahead while nothing can raise an interrupt
+        u32 idle = gb->cpu.int_flags ? 0 : emu_idle_cycles();
 
-        if (ctx.int_flags) {
-            ctx.halted = false;
+        if (idle) {
+            emu_skip_cycles(idle);
+        } else {
+            emu_cycles(1);
+        }
+
+        if (gb->cpu.int_flags) {
+            gb->cpu.halted = false;
         }
     }
 
-    if (ctx.int_master_enabled) {
-        cpu_handle_interrupts(&ctx);
-        ctx.enabling_ime = false;
+    if (gb->cpu.int_master_enabled) {
+        cpu_handle_interrupts(&gb->cpu);
+        gb->cpu.enabling_ime = false;
     }
 
-    if (ctx.enabling_ime) {
-        ctx.int_master_enabled = true;
+    if (gb->cpu.enabling_ime) {
+        gb->cpu.int_master_enabled = true;
+    }
+
+    if (gb->cpu.regs.pc < pc) {
+        // Backward branch (or an interrupt), may close an idle loop
+        cpu_idle_branch(pc);
     }
 
     return true;
 }
 
+static bool cpu_exec_core(u32 steps) {
+    if (gb->core == CORE_THREADED) {
+        return cpu_threaded_exec(steps);
+    }
+
+    if (gb->core == CORE_DYNAREC) {
+        return cpu_dynarec_exec(steps);
+    }
+
+    for (u32 i = 0; i < steps; i++) {
+        if (!cpu_step()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool cpu_exec(u32 steps) {
+    bool ok = cpu_exec_core(steps);
+
+    // Hand back a machine whose timer and PPU are caught up with the CPU
+    emu_sync();
+
+    return ok;
+}
+
+void cpu_set_core(cpu_core c) {
+    gb->core = c;
+}
+
+cpu_core cpu_get_core() {
+    return gb->core;
+}
+
 u8 cpu_get_ie_register() {
-    return ctx.ie_register;
+    return gb->cpu.ie_register;
 }
 
 void cpu_set_ie_register(u8 n) {
-    ctx.ie_register = n;
+    gb->cpu.ie_register = n;
 }
 
 void cpu_request_interrupt(interrupt_type t) {
-    ctx.int_flags |= t;
+    gb->cpu.int_flags |= t;
 }
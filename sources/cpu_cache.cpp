@@ -0,0 +1,94 @@
+#include <./../headers/cpu_cache.hpp>
+#include <./../headers/bus.hpp>
+#include <./../headers/cart.hpp>
+#include <./../headers/inst_table.hpp>
+#include <./../headers/gameboy.hpp>
+#include <string.h>
+
+// Only code in ROM, WRAM and HRAM is cached. ROM never changes under a given
+// bank, WRAM/HRAM entries are dropped by cpu_cache_invalidate() on write.
+
+void cpu_cache_init() {
+    memset(&gb->cpu_cache, 0, sizeof(gb->cpu_cache));
+}
+
+// Returns the slot for the address and the last address of its region
+static decoded_inst *cache_slot(u16 address, u16 *region_end) {
+    if (address < 0x4000) {
+        *region_end = 0x3FFF;
+        return &gb->cpu_cache.rom0[address];
+    }
+
+    if (address < 0x8000) {
+        *region_end = 0x7FFF;
+        return &gb->cpu_cache.romx[address - 0x4000];
+    }
+
+    if (BETWEEN(address, 0xC000, 0xDFFF)) {
+        *region_end = 0xDFFF;
+        return &gb->cpu_cache.wram[address - 0xC000];
+    }
+
+    if (BETWEEN(address, 0xFF80, 0xFFFE)) {
+        *region_end = 0xFFFE;
+        return &gb->cpu_cache.hram[address - 0xFF80];
+    }
+
+    return nullptr;
+}
+
+decoded_inst *cpu_cache_lookup(u16 pc) {
+    u16 region_end;
+    decoded_inst *e = cache_slot(pc, &region_end);
+
+    if (!e) {
+        return nullptr;
+    }
+
+    u8 bank = (pc >= 0x4000 && pc < 0x8000) ? cart_get_context()->rom_bank_value : 0;
+
+    if (e->valid && e->bank == bank) {
+        return e;
+    }
+
+    u8 opcode = bus_read(pc);
+    const instruction *inst = instruction_by_opcode(opcode);
+    u8 length = 1 + inst_immediate_bytes(inst->mode);
+
+    if (pc + length - 1 > region_end) {
+        // Operands spill into the next region, don't cache it
+        return nullptr;
+    }
+
+    e->inst = inst;
+    e->proc = cpu_op_handler(opcode);
+    e->opcode = opcode;
+    e->length = length;
+    e->operand = 0;
+
+    if (length > 1) {
+        e->operand = bus_read(pc + 1);
+    }
+
+    if (length > 2) {
+        e->operand |= bus_read(pc + 2) << 8;
+    }
+
+    e->bank = bank;
+    e->valid = true;
+
+    return e;
+}
+
+void cpu_cache_invalidate(u16 address) {
+    // Instructions are at most 3 bytes, so only entries starting at the
+    // written byte or the two before it can contain it
+    for (int i = 0; i < 3; i++) {
+        u16 region_end;
+        decoded_inst *e = cache_slot(address - i, &region_end);
+
+        if (e) {
+            e->valid = false;
+        }
+    }
+}
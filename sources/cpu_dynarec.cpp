@@ -0,0 +1,1441 @@
+#include <./../headers/cpu_dynarec.hpp>
+#include <./../headers/cpu.hpp>
+#include <./../headers/cpu_cache.hpp>
+#include <./../headers/cpu_flags.hpp>
+#include <./../headers/cpu_idle.hpp>
+#include <./../headers/inst_table.hpp>
+#include <./../headers/interrupts.hpp>
+#include <./../headers/bus.hpp>
+#include <./../headers/cart.hpp>
+#include <./../headers/dbg.hpp>
+#include <./../headers/main.hpp>
+#include <./../headers/gameboy.hpp>
+#include <string.h>
+#include <initializer_list>
+
+// ROM basic blocks are translated into x86-64 code. Register moves, ALU ops
+// (flags computed from the host flags with lahf), 16-bit arithmetic, CB ops,
+// loads/stores, PUSH/POP and the branches run as host instructions on the
+// registers in gb->cpu, memory goes through bus_read() / jit_write(). The
+// rest (DAA, HALT, EI, RETI, ADD SP...) calls the opcode handler.
+//
+// Cycles are counted at translation time and added to emu.ticks/pending in
+// one go before every bus access, helper call and block exit, so the timer,
+// PPU and DMA see the same clock as under cpu_step(). That is only exact as
+// long as no event falls inside the banked cycles: every stretch between two
+// checks (block entry, after a store or a handler call, every few cycles)
+// only runs as host code when pending + its cycles fits in emu.budget,
+// otherwise its slow path runs the same instructions one by one through
+// their handlers. Stores outside RAM and handler calls go through
+// jit_inst_end(), the interrupt / EI / idle loop part of cpu_step().
+//
+// Only ROM is translated. WRAM/HRAM code can modify itself and always goes
+// through the interpreter. Blocks in 0x4000 - 0x7FFF are tagged with the bank
+// they were translated under, and a bank switch ends the running block.
+//
+// The code buffer is never writable and executable at once: it is mapped
+// read/execute, and only the pages a block is being written to are switched
+// to read/write until it is done.
+
+#if defined(__x86_64__) && defined(__unix__)
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#define JIT_CODE_SIZE   (32 * 1024 * 1024)
+#define JIT_MAX_ENTRIES (512 * 1024)
+#define JIT_BLOCK_MAX   32              // Instructions per block
+
+// Longest host code of one instruction (a conditional CALL, its budget check
+// and slow path) and of a block
+#define JIT_INST_BYTES  256
+#define JIT_BLOCK_BYTES (16 + JIT_BLOCK_MAX * JIT_INST_BYTES)
+
+// M-cycles between budget checks in a run without stores
+#define JIT_SEGMENT_CYCLES 12
+
+// Returns the number of instructions it ran
+typedef u32 (*jit_fn)(gameboy *instance);
+
+void cpu_dynarec_flush() {
+    gb->jit.code_used = 0;
+    gb->jit.entries_used = 0;
+
+    memset(gb->jit.rom0, 0, sizeof(gb->jit.rom0));
+    memset(gb->jit.romx, 0, sizeof(gb->jit.romx));
+}
+
+void cpu_dynarec_bank_switch() {
+    gb->jit.exit_block = true;
+}
+
+static bool jit_init() {
+    if (gb->jit.code || gb->jit.disabled) {
+        return !gb->jit.disabled;
+    }
+
+    void *mem = mmap(nullptr, JIT_CODE_SIZE, PROT_READ | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (mem == MAP_FAILED) {
+        fprintf(stderr, "DYNAREC: no memory for the code buffer, using the interpreter\n");
+        gb->jit.disabled = true;
+        return false;
+    }
+
+    gb->jit.code = (u8 *)mem;
+    gb->jit.entries = new jit_entry[JIT_MAX_ENTRIES];
+
+    cpu_dynarec_flush();
+    return true;
+}
+
+void cpu_dynarec_free() {
+    if (gb->jit.code) {
+        munmap(gb->jit.code, JIT_CODE_SIZE);
+        delete[] gb->jit.entries;
+    }
+
+    gb->jit.code = nullptr;
+    gb->jit.entries = nullptr;
+}
+
+// The pages of `size` bytes at `p`: read/write while a block is written
+// there, read/execute once it is done
+static bool jit_protect(u8 *p, u32 size, bool writable) {
+    uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)p & ~(page - 1);
+    uintptr_t end = ((uintptr_t)p + size + page - 1) & ~(page - 1);
+    int prot = writable ? PROT_READ | PROT_WRITE : PROT_READ | PROT_EXEC;
+
+    if (mprotect((void *)start, end - start, prot)) {
+        fprintf(stderr, "DYNAREC: mprotect failed, using the interpreter\n");
+        gb->jit.disabled = true;
+        return false;
+    }
+
+    return true;
+}
+
+// Runtime helpers, called from translated code
+
+// Interrupts, EI and idle loops after the instruction at `pc` (see cpu_step()).
+// Returns false when the block has to be left.
+static bool jit_inst_end(u16 pc, u16 next_pc) {
+    gb->jit.check = false;
+
+    if (gb->cpu.int_master_enabled) {
+        cpu_handle_interrupts(&gb->cpu);
+        gb->cpu.enabling_ime = false;
+    }
+
+    if (gb->cpu.enabling_ime) {
+        gb->cpu.int_master_enabled = true;
+    }
+
+    if (gb->cpu.regs.pc < pc) {
+        cpu_idle_branch(pc);
+    }
+
+    return gb->cpu.regs.pc == next_pc && !gb->jit.exit_block && !gb->cpu.halted && !gb->cpu.enabling_ime;
+}
+
+// Instruction without host code: the opcode handler, as cpu_step() runs it
+static bool jit_exec_inst(jit_entry *e) {
+    gb->cpu.decoded = &e->decoded;
+    gb->cpu.current_opcode = e->decoded.opcode;
+    gb->cpu.current_inst = e->decoded.inst;
+    gb->cpu.regs.pc = e->pc + 1;
+
+    emu_cycles(e->decoded.length);
+    e->decoded.proc(&gb->cpu);
+
+    // Translated code reads F directly
+    cpu_flags_sync(&gb->cpu);
+
+    return jit_inst_end(e->pc, e->next_pc);
+}
+
+// Slow path of a budget check, its `count` instructions through
+// jit_exec_inst(). Returns how many ran, shifted left, bit 0 set when the
+// block has to be left.
+static u32 jit_exec_slow(jit_entry *e, u32 count) {
+    for (u32 i = 0; i < count; i++) {
+        if (!jit_exec_inst(&e[i])) {
+            return ((i + 1) << 1) | 1;
+        }
+    }
+
+    return count << 1;
+}
+
+// ERAM, WRAM, echo RAM and HRAM don't reach the timer, the PPU, the
+// interrupt registers or the MBC, any other store needs jit_inst_end()
+static void jit_write(u16 address, u8 value) {
+    bus_write(address, value);
+
+    if (!BETWEEN(address, 0xA000, 0xFDFF) && !BETWEEN(address, 0xFF80, 0xFFFE)) {
+        gb->jit.check = true;
+    }
+}
+
+// Emitter
+
+// A budget check and the instructions it covers, the slow path runs those
+// through jit_exec_inst() when an event falls inside them
+typedef struct {
+    u8 *at;
+    u8 *slow;           // rel32 of the jump to the slow path
+    u32 first;          // Index of the first instruction
+} jit_check;
+
+typedef struct {
+    u8 *p;
+    u32 deferred;       // M-cycles not added to emu.ticks/pending yet
+    u32 segment;        // M-cycles since the last budget check
+    u8 *segment_imm;    // Its cycle count in that check
+    bool serial;        // dbg_update() check due at the next instruction
+    bool written;       // A store since the last budget check, it may have moved the budget
+
+    jit_check checks[JIT_BLOCK_MAX + 1];
+    u32 check_count;
+} jit_emitter;
+
+enum {
+    X_EAX = 0,
+    X_ECX = 1,
+    X_EDX = 2,
+    X_ESI = 6,
+    X_EDI = 7
+};
+
+// Displacement of a gameboy field from rbx, which holds the instance
+#define JIT_OFF(field) ((u32)((u8 *)&(field) - (u8 *)gb))
+#define JIT_R8(rt) JIT_OFF(gb->cpu.regs.r8[cpu_reg8_index(rt)])
+#define JIT_R16(rt) JIT_OFF(gb->cpu.regs.r16[cpu_reg16_index(rt)])
+#define JIT_F JIT_OFF(gb->cpu.regs.f)
+#define JIT_PC JIT_OFF(gb->cpu.regs.pc)
+#define JIT_SP JIT_OFF(gb->cpu.regs.sp)
+
+static void emit(jit_emitter *x, std::initializer_list<u8> bytes) {
+    for (u8 b : bytes) {
+        *x->p++ = b;
+    }
+}
+
+static void emit_u32(jit_emitter *x, u32 v) {
+    memcpy(x->p, &v, 4);
+    x->p += 4;
+}
+
+static void emit_u64(jit_emitter *x, u64 v) {
+    memcpy(x->p, &v, 8);
+    x->p += 8;
+}
+
+// <opcode> reg, [rbx + off]
+static void emit_mem(jit_emitter *x, std::initializer_list<u8> opcode, u8 reg, u32 off) {
+    emit(x, opcode);
+    emit(x, {(u8)(0x83 | (reg << 3))});
+    emit_u32(x, off);
+}
+
+static void emit_load8(jit_emitter *x, u8 reg, u32 off) {
+    emit_mem(x, {0x0F, 0xB6}, reg, off);                    // movzx reg, byte [off]
+}
+
+static void emit_load16(jit_emitter *x, u8 reg, u32 off) {
+    emit_mem(x, {0x0F, 0xB7}, reg, off);                    // movzx reg, word [off]
+}
+
+static void emit_store8(jit_emitter *x, u8 reg, u32 off) {
+    emit_mem(x, {0x88}, reg, off);                          // mov [off], reg8
+}
+
+static void emit_store8_imm(jit_emitter *x, u32 off, u8 v) {
+    emit_mem(x, {0xC6}, 0, off);                            // mov byte [off], imm8
+    emit(x, {v});
+}
+
+static void emit_store16_imm(jit_emitter *x, u32 off, u16 v) {
+    emit_mem(x, {0x66, 0xC7}, 0, off);                      // mov word [off], imm16
+    emit(x, {(u8)v, (u8)(v >> 8)});
+}
+
+// and/or/xor/cmp byte [off], imm8 (group 1 extension in `ext`)
+static void emit_alu8_imm(jit_emitter *x, u8 ext, u32 off, u8 v) {
+    emit_mem(x, {0x80}, ext, off);
+    emit(x, {v});
+}
+
+#define X_OR 1
+#define X_AND 4
+#define X_XOR 6
+#define X_CMP 7
+
+static void emit_test8_imm(jit_emitter *x, u32 off, u8 v) {
+    emit_mem(x, {0xF6}, 0, off);                            // test byte [off], imm8
+    emit(x, {v});
+}
+
+static void emit_inc16(jit_emitter *x, u32 off, int delta) {
+    emit_mem(x, {0x66, 0xFF}, delta > 0 ? 0 : 1, off);      // inc/dec word [off]
+}
+
+static void emit_mov_imm(jit_emitter *x, u8 reg, u32 v) {
+    emit(x, {(u8)(0xB8 + reg)});                            // mov reg, imm32
+    emit_u32(x, v);
+}
+
+static void emit_call(jit_emitter *x, const void *fn) {
+    emit(x, {0x48, 0xB8});                                  // mov rax, imm64
+    emit_u64(x, (u64)fn);
+    emit(x, {0xFF, 0xD0});                                  // call rax
+}
+
+// Forward jumps, patched once the target is known
+static u8 *emit_jcc8(jit_emitter *x, u8 opcode) {
+    emit(x, {opcode, 0});
+    return x->p - 1;
+}
+
+static void patch8(jit_emitter *x, u8 *rel) {
+    *rel = (u8)(x->p - (rel + 1));
+}
+
+static u8 *emit_jcc32(jit_emitter *x, u8 opcode) {
+    emit(x, {0x0F, opcode});
+    emit_u32(x, 0);
+    return x->p - 4;
+}
+
+static void patch32(jit_emitter *x, u8 *rel) {
+    u32 v = (u32)(x->p - (rel + 4));
+    memcpy(rel, &v, 4);
+}
+
+// Leaves the block, `n` instructions done
+static void emit_exit(jit_emitter *x, u32 n) {
+    emit_mov_imm(x, X_EAX, n);
+    emit(x, {0x5B, 0xC3});                                  // pop rbx; ret
+}
+
+// Leaves the block if the helper just called returned false
+static void emit_exit_unless(jit_emitter *x, u32 n) {
+    emit(x, {0x84, 0xC0});                                  // test al, al
+    u8 *skip = emit_jcc8(x, 0x75);                          // jnz
+    emit_exit(x, n);
+    patch8(x, skip);
+}
+
+// Cycles
+
+static void jit_defer(jit_emitter *x, u32 cycles) {
+    x->deferred += cycles;
+    x->segment += cycles;
+}
+
+// What emu_cycles() does, without the sync: the budget checks guarantee
+// that none would have happened
+static void emit_add_cycles(jit_emitter *x, u32 cycles) {
+    if (cycles) {
+        emit_mem(x, {0x48, 0x81}, 0, JIT_OFF(gb->emu.ticks));   // add qword [ticks], imm32
+        emit_u32(x, cycles * 4);
+        emit_mem(x, {0x81}, 0, JIT_OFF(gb->emu.pending));       // add dword [pending], imm32
+        emit_u32(x, cycles);
+    }
+}
+
+static void emit_flush(jit_emitter *x) {
+    if (x->written && x->deferred) {
+        // A store to the timer or LCD can leave no budget, sync like
+        // emu_cycles() does. Keeps edi/esi, the bus call may follow.
+        emit(x, {0x57, 0x56});                              // push rdi; push rsi
+        emit_mov_imm(x, X_EDI, x->deferred);
+        emit_call(x, (const void *)emu_cycles);
+        emit(x, {0x5E, 0x5F});                              // pop rsi; pop rdi
+    } else {
+        emit_add_cycles(x, x->deferred);
+    }
+
+    x->deferred = 0;
+}
+
+static void jit_end_segment(jit_emitter *x) {
+    if (x->segment_imm) {
+        memcpy(x->segment_imm, &x->segment, 4);
+    }
+
+    x->segment = 0;
+}
+
+// Goes to the slow path unless the cycles up to the next check fit in the
+// budget. `n` instructions are done, no cycles deferred.
+static void emit_budget_check(jit_emitter *x, u32 n) {
+    jit_end_segment(x);
+    x->written = false;
+
+    jit_check *c = &x->checks[x->check_count++];
+    c->at = x->p;
+    c->first = n;
+
+    emit_mem(x, {0x8B}, X_EAX, JIT_OFF(gb->emu.pending));   // mov eax, [pending]
+    emit(x, {0x05});                                        // add eax, imm32
+    x->segment_imm = x->p;
+    emit_u32(x, 0);
+    emit_mem(x, {0x3B}, X_EAX, JIT_OFF(gb->emu.budget));    // cmp eax, [budget]
+
+    c->slow = emit_jcc32(x, 0x87);                          // ja
+}
+
+// dbg_update() of the handler, only does something once SC was written
+static void emit_serial(jit_emitter *x) {
+    if (!x->serial) {
+        return;
+    }
+
+    x->serial = false;
+
+    emit_alu8_imm(x, X_CMP, JIT_OFF(gb->io.serial_data[1]), 0x81);
+    u8 *skip = emit_jcc8(x, 0x75);                          // jne
+    emit_call(x, (const void *)dbg_update);
+    patch8(x, skip);
+}
+
+// Bus
+
+// edi = the address in `rt`: a register pair, or 0xFF00 | C
+static void emit_address(jit_emitter *x, reg_type rt) {
+    if (rt == RT_C) {
+        emit_load8(x, X_EDI, JIT_R8(RT_C));
+        emit(x, {0x81, 0xCF});                              // or edi, 0xFF00
+        emit_u32(x, 0xFF00);
+    } else {
+        emit_load16(x, X_EDI, JIT_R16(rt));
+    }
+}
+
+// al = bus_read(edi)
+static void emit_read(jit_emitter *x) {
+    emit_flush(x);
+    emit_call(x, (const void *)bus_read);
+}
+
+// jit_write(edi, esi)
+static void emit_write(jit_emitter *x) {
+    emit_flush(x);
+    emit_call(x, (const void *)jit_write);
+    x->written = true;
+}
+
+// stack_push(esi)
+static void emit_push(jit_emitter *x) {
+    emit_inc16(x, JIT_SP, -1);
+    emit_load16(x, X_EDI, JIT_SP);
+    emit_write(x);
+}
+
+// End of an instruction that stored something: jit_inst_end() if the store
+// needs it, then the budget for what follows
+static void emit_store_end(jit_emitter *x, const jit_entry *e, u32 n) {
+    emit_flush(x);
+
+    emit_alu8_imm(x, X_CMP, JIT_OFF(gb->jit.check), 0);
+    u8 *skip = emit_jcc8(x, 0x74);                          // je
+    emit_store16_imm(x, JIT_PC, e->next_pc);
+    emit_mov_imm(x, X_EDI, e->pc);
+    emit_mov_imm(x, X_ESI, e->next_pc);
+    emit_call(x, (const void *)jit_inst_end);
+    emit_exit_unless(x, n);
+    patch8(x, skip);
+
+    x->serial = true;
+    emit_budget_check(x, n);
+}
+
+// Flags
+
+typedef enum {
+    JF_ARITH,           // Z, H and C from the host
+    JF_INCDEC,          // Z and H, C kept
+    JF_LOGIC            // Z only
+} jit_flags;
+
+// F from the host flags lahf left in ah (ZF bit 6, AF bit 4, CF bit 0),
+// `set` holds N / H when the op sets them
+static void emit_flags(jit_emitter *x, jit_flags kind, u8 set) {
+    emit(x, {0x0F, 0xB6, 0xCC});                            // movzx ecx, ah
+    emit_load8(x, X_EDX, JIT_F);
+    emit(x, {0x83, 0xE2, (u8)(kind == JF_INCDEC ? 0x1F : 0x0F)});   // and edx, kept bits
+    emit(x, {0x89, 0xC8});                                  // mov eax, ecx
+    emit(x, {0x83, 0xE0, (u8)(kind == JF_LOGIC ? 0x40 : 0x50)});    // and eax, ZF | AF
+    emit(x, {0x01, 0xC0});                                  // add eax, eax: Z bit 7, H bit 5
+    emit(x, {0x09, 0xC2});                                  // or edx, eax
+
+    if (kind == JF_ARITH) {
+        emit(x, {0x83, 0xE1, 0x01});                        // and ecx, CF
+        emit(x, {0xC1, 0xE1, 0x04});                        // shl ecx, 4
+        emit(x, {0x09, 0xCA});                              // or edx, ecx
+    }
+
+    if (set) {
+        emit(x, {0x83, 0xCA, set});                         // or edx, set
+    }
+
+    emit_store8(x, X_EDX, JIT_F);
+}
+
+// CF = the GB carry, for ADC/SBC/RLA/RRA/RL/RR
+static void emit_carry_in(jit_emitter *x) {
+    emit_load8(x, X_EDX, JIT_F);
+    emit(x, {0x0F, 0xBA, 0xE2, 0x04});                      // bt edx, 4
+}
+
+// F = Z? 0 0 C from setc cl / setz dl, low nibble kept
+static void emit_flags_zc(jit_emitter *x, bool z) {
+    emit(x, {0x0F, 0xB6, 0xC9});                            // movzx ecx, cl
+    emit(x, {0xC1, 0xE1, 0x04});                            // shl ecx, 4
+
+    if (z) {
+        emit(x, {0x0F, 0xB6, 0xD2});                        // movzx edx, dl
+        emit(x, {0xC1, 0xE2, 0x07});                        // shl edx, 7
+        emit(x, {0x09, 0xCA});                              // or edx, ecx
+    } else {
+        emit(x, {0x89, 0xCA});                              // mov edx, ecx
+    }
+
+    emit_load8(x, X_ECX, JIT_F);
+    emit(x, {0x83, 0xE1, 0x0F});                            // and ecx, 0x0F
+    emit(x, {0x09, 0xCA});                                  // or edx, ecx
+    emit_store8(x, X_EDX, JIT_F);
+}
+
+// BIT: Z from the test just done, N = 0, H = 1, C kept
+static void emit_bit(jit_emitter *x, u32 off, u8 mask) {
+    emit_load8(x, X_EDX, JIT_F);
+    emit(x, {0x83, 0xE2, 0x1F});                            // and edx, 0x1F
+    emit(x, {0x83, 0xCA, 0x20});                            // or edx, 0x20
+
+    if (off) {
+        emit_test8_imm(x, off, mask);
+    } else {
+        emit(x, {0xA8, mask});                              // test al, mask
+    }
+
+    emit(x, {0x75, 0x03});                                  // jnz +3
+    emit(x, {0x83, 0xCA, 0x80});                            // or edx, 0x80
+    emit_store8(x, X_EDX, JIT_F);
+}
+
+// Branches
+
+// Jumps to the returned (patched) label when `cond` doesn't hold
+static u8 *emit_cond_skip(jit_emitter *x, cond_type cond) {
+    bool z = cond == CT_NZ || cond == CT_Z;
+
+    emit_test8_imm(x, JIT_F, z ? 0x80 : 0x10);
+    return emit_jcc32(x, cond == CT_NZ || cond == CT_NC ? 0x85 : 0x84);
+}
+
+// cpu_idle_branch() when the PC just loaded into eax went backwards
+static void emit_idle_check(jit_emitter *x, const jit_entry *e) {
+    emit(x, {0x3D});                                        // cmp eax, pc
+    emit_u32(x, e->pc);
+    u8 *skip = emit_jcc8(x, 0x73);                          // jae
+    emit_mov_imm(x, X_EDI, e->pc);
+    emit_call(x, (const void *)cpu_idle_branch);
+    patch8(x, skip);
+}
+
+// Taken JP/JR to a known target
+static void emit_jump(jit_emitter *x, const jit_entry *e, u16 target, u32 n) {
+    jit_defer(x, 1);
+    emit_flush(x);
+
+    emit_store16_imm(x, JIT_PC, target);
+
+    if (target < e->pc) {
+        emit_mov_imm(x, X_EDI, e->pc);
+        emit_call(x, (const void *)cpu_idle_branch);
+    }
+
+    emit_exit(x, n);
+}
+
+// Taken CALL/RST: 2 cycles, PC pushed, 1 cycle
+static void emit_call_taken(jit_emitter *x, const jit_entry *e, u16 target, u32 n) {
+    jit_defer(x, 2);
+    emit_mov_imm(x, X_ESI, e->next_pc >> 8);
+    emit_push(x);
+    emit_mov_imm(x, X_ESI, e->next_pc & 0xFF);
+    emit_push(x);
+    emit_store16_imm(x, JIT_PC, target);
+    jit_defer(x, 1);
+    emit_flush(x);
+
+    // jit_inst_end() checks the idle loop too
+    emit_alu8_imm(x, X_CMP, JIT_OFF(gb->jit.check), 0);
+    u8 *plain = emit_jcc8(x, 0x74);                         // je
+    emit_mov_imm(x, X_EDI, e->pc);
+    emit_mov_imm(x, X_ESI, target);
+    emit_call(x, (const void *)jit_inst_end);
+    emit_exit(x, n);
+    patch8(x, plain);
+
+    if (target < e->pc) {
+        emit_mov_imm(x, X_EDI, e->pc);
+        emit_call(x, (const void *)cpu_idle_branch);
+    }
+
+    emit_exit(x, n);
+}
+
+// Taken RET: pop the low byte, 1 cycle, the high byte, 2 cycles
+static void emit_ret_taken(jit_emitter *x, const jit_entry *e, u32 n) {
+    emit_load16(x, X_EDI, JIT_SP);
+    emit_read(x);
+    emit_store8(x, X_EAX, JIT_PC);
+    emit_inc16(x, JIT_SP, 1);
+    jit_defer(x, 1);
+
+    emit_load16(x, X_EDI, JIT_SP);
+    emit_read(x);
+    emit_store8(x, X_EAX, JIT_PC + 1);
+    emit_inc16(x, JIT_SP, 1);
+    jit_defer(x, 2);
+    emit_flush(x);
+
+    emit_load16(x, X_EAX, JIT_PC);
+    emit_idle_check(x, e);
+    emit_exit(x, n);
+}
+
+// Instructions
+
+// Has host code, the rest goes through jit_exec_inst()
+static bool jit_native(const instruction *inst, u8 operand) {
+    switch (inst->type) {
+        case IN_NOP:
+        case IN_LDH:
+        case IN_INC:
+        case IN_DEC:
+        case IN_ADC:
+        case IN_SUB:
+        case IN_SBC:
+        case IN_AND:
+        case IN_XOR:
+        case IN_OR:
+        case IN_CP:
+        case IN_RLCA:
+        case IN_RRCA:
+        case IN_RLA:
+        case IN_RRA:
+        case IN_CPL:
+        case IN_SCF:
+        case IN_CCF:
+        case IN_DI:
+        case IN_PUSH:
+        case IN_POP:
+        case IN_JR:
+        case IN_RET:
+        case IN_RST:
+            return true;
+
+        case IN_ADD:
+            return inst->reg_1 != RT_SP;
+
+        case IN_LD:
+            return inst->mode != AM_HL_SPR && !(inst->mode == AM_A16_R && inst->reg_2 == RT_SP);
+
+        case IN_JP:
+            return inst->mode == AM_D16 || inst->mode == AM_R;
+
+        case IN_CALL:
+            return inst->mode == AM_D16;
+
+        case IN_CB:
+            // (HL) only for BIT, the others read and write it with cycles between
+            return (operand & 0b111) != 6 || (operand >> 6) == 1;
+
+        default:
+            return false;
+    }
+}
+
+static void emit_ld(jit_emitter *x, const jit_entry *e, u32 n) {
+    const instruction *inst = e->decoded.inst;
+    reg_type r1 = inst->reg_1;
+    reg_type r2 = inst->reg_2;
+    int hl_delta = inst->mode == AM_R_HLI || inst->mode == AM_HLI_R ? 1 : -1;
+
+    switch (inst->mode) {
+        case AM_R_R:
+            if (r1 >= RT_AF) {
+                // LD SP, HL
+                emit_load16(x, X_EAX, JIT_R16(r2));
+                emit_mem(x, {0x66, 0x89}, X_EAX, JIT_R16(r1));   // mov [r1], ax
+            } else {
+                emit_load8(x, X_EAX, JIT_R8(r2));
+                emit_store8(x, X_EAX, JIT_R8(r1));
+            }
+
+            emit_serial(x);
+            break;
+
+        case AM_R_D8:
+            emit_store8_imm(x, JIT_R8(r1), e->decoded.operand);
+            emit_serial(x);
+            break;
+
+        case AM_R_D16:
+            emit_store16_imm(x, JIT_R16(r1), e->decoded.operand);
+            emit_serial(x);
+            break;
+
+        case AM_R_MR:
+        case AM_R_HLI:
+        case AM_R_HLD:
+        case AM_R_A16:
+            // Read during the operand fetch, before dbg_update()
+            if (inst->mode == AM_R_A16) {
+                emit_mov_imm(x, X_EDI, e->decoded.operand);
+            } else {
+                emit_address(x, r2);
+            }
+
+            emit_read(x);
+            jit_defer(x, 1);
+            emit_store8(x, X_EAX, JIT_R8(r1));
+
+            if (inst->mode == AM_R_HLI || inst->mode == AM_R_HLD) {
+                emit_inc16(x, JIT_R16(RT_HL), hl_delta);
+            }
+
+            emit_serial(x);
+            break;
+
+        default:
+            // Stores: AM_MR_R, AM_HLI_R, AM_HLD_R, AM_A16_R, AM_MR_D8
+            emit_serial(x);
+
+            if (inst->mode == AM_A16_R) {
+                emit_mov_imm(x, X_EDI, e->decoded.operand);
+            } else {
+                emit_address(x, r1);
+            }
+
+            if (inst->mode == AM_HLI_R || inst->mode == AM_HLD_R) {
+                emit_inc16(x, JIT_R16(RT_HL), hl_delta);
+            }
+
+            if (inst->mode == AM_MR_D8) {
+                emit_mov_imm(x, X_ESI, e->decoded.operand & 0xFF);
+            } else {
+                emit_load8(x, X_ESI, JIT_R8(r2));
+            }
+
+            emit_write(x);
+            jit_defer(x, 1);
+            emit_store_end(x, e, n);
+            break;
+    }
+}
+
+static void emit_inc_dec(jit_emitter *x, const jit_entry *e, u32 n) {
+    const instruction *inst = e->decoded.inst;
+    reg_type r1 = inst->reg_1;
+    bool inc = inst->type == IN_INC;
+
+    if (inst->mode == AM_MR) {
+        // (HL): read by the operand fetch, 1 cycle, dbg_update(), 1 cycle,
+        // read again and stored
+        emit_address(x, RT_HL);
+        emit_read(x);
+        jit_defer(x, 1);
+        emit_serial(x);
+        jit_defer(x, 1);
+
+        emit_address(x, RT_HL);
+        emit_read(x);
+        emit(x, {0xFE, (u8)(inc ? 0xC0 : 0xC8)});          // inc/dec al
+        emit(x, {0x9F});                                    // lahf
+        emit(x, {0x0F, 0xB6, 0xF0});                        // movzx esi, al
+        emit_flags(x, JF_INCDEC, inc ? 0 : 0x40);
+
+        emit_address(x, RT_HL);
+        emit_write(x);
+        emit_store_end(x, e, n);
+        return;
+    }
+
+    emit_serial(x);
+
+    if (r1 >= RT_AF) {
+        jit_defer(x, 1);
+        emit_inc16(x, JIT_R16(r1), inc ? 1 : -1);
+        return;
+    }
+
+    emit_load8(x, X_EAX, JIT_R8(r1));
+    emit(x, {0xFE, (u8)(inc ? 0xC0 : 0xC8)});              // inc/dec al
+    emit(x, {0x9F});                                        // lahf
+    emit_store8(x, X_EAX, JIT_R8(r1));
+    emit_flags(x, JF_INCDEC, inc ? 0 : 0x40);
+}
+
+// ADD HL, rr: N = 0, H from bit 11, C from bit 15, Z kept
+static void emit_add_hl(jit_emitter *x, const jit_entry *e) {
+    emit_serial(x);
+    jit_defer(x, 1);
+
+    emit_load16(x, X_EAX, JIT_R16(RT_HL));
+    emit_load16(x, X_ECX, JIT_R16(e->decoded.inst->reg_2));
+    emit(x, {0x8D, 0x14, 0x08});                            // lea edx, [rax + rcx]
+    emit_mem(x, {0x66, 0x89}, X_EDX, JIT_R16(RT_HL));       // mov [hl], dx
+    emit(x, {0x31, 0xC8});                                  // xor eax, ecx
+    emit(x, {0x31, 0xD0});                                  // xor eax, edx: carries into each bit
+    emit(x, {0xC1, 0xE8, 0x07});                            // shr eax, 7
+    emit(x, {0x83, 0xE0, 0x20});                            // and eax, 0x20
+    emit(x, {0xC1, 0xEA, 0x0C});                            // shr edx, 12
+    emit(x, {0x83, 0xE2, 0x10});                            // and edx, 0x10
+    emit(x, {0x09, 0xD0});                                  // or eax, edx
+    emit_load8(x, X_EDX, JIT_F);
+    emit(x, {0x83, 0xE2, 0x8F});                            // and edx, 0x8F
+    emit(x, {0x09, 0xC2});                                  // or edx, eax
+    emit_store8(x, X_EDX, JIT_F);
+}
+
+// 8-bit ALU ops on A
+static void emit_alu(jit_emitter *x, const jit_entry *e) {
+    const instruction *inst = e->decoded.inst;
+
+    if (inst->mode == AM_R_MR) {
+        emit_address(x, inst->reg_2);
+        emit_read(x);
+        jit_defer(x, 1);
+        emit(x, {0x0F, 0xB6, 0xC8});                        // movzx ecx, al
+    } else {
+        emit_serial(x);
+
+        if (inst->mode == AM_R_D8) {
+            emit_mov_imm(x, X_ECX, e->decoded.operand & 0xFF);
+        } else {
+            emit_load8(x, X_ECX, JIT_R8(inst->reg_2));
+        }
+    }
+
+    if (inst->type == IN_ADC || inst->type == IN_SBC) {
+        emit_carry_in(x);
+    }
+
+    emit_load8(x, X_EAX, JIT_R8(RT_A));
+
+    switch (inst->type) {
+        case IN_ADD: emit(x, {0x00, 0xC8}); break;         // add al, cl
+        case IN_ADC: emit(x, {0x10, 0xC8}); break;         // adc al, cl
+        case IN_SUB: emit(x, {0x28, 0xC8}); break;         // sub al, cl
+        case IN_SBC: emit(x, {0x18, 0xC8}); break;         // sbb al, cl
+        case IN_AND: emit(x, {0x20, 0xC8}); break;         // and al, cl
+        case IN_XOR: emit(x, {0x30, 0xC8}); break;         // xor al, cl
+        case IN_OR:  emit(x, {0x08, 0xC8}); break;         // or al, cl
+        default:     emit(x, {0x38, 0xC8}); break;         // cmp al, cl
+    }
+
+    emit(x, {0x9F});                                        // lahf
+
+    if (inst->type != IN_CP) {
+        emit_store8(x, X_EAX, JIT_R8(RT_A));
+    }
+
+    switch (inst->type) {
+        case IN_ADD:
+        case IN_ADC:
+            emit_flags(x, JF_ARITH, 0);
+            break;
+
+        case IN_AND:
+            emit_flags(x, JF_LOGIC, 0x20);
+            break;
+
+        case IN_XOR:
+        case IN_OR:
+            emit_flags(x, JF_LOGIC, 0);
+            break;
+
+        default:
+            emit_flags(x, JF_ARITH, 0x40);
+            break;
+    }
+
+    // The (HL) operand was read before dbg_update()
+    emit_serial(x);
+}
+
+// RLCA, RRCA, RLA, RRA: Z, N and H cleared
+static void emit_rotate_a(jit_emitter *x, in_type type) {
+    emit_serial(x);
+
+    if (type == IN_RLA || type == IN_RRA) {
+        emit_carry_in(x);
+    }
+
+    emit_load8(x, X_EAX, JIT_R8(RT_A));
+
+    switch (type) {
+        case IN_RLCA: emit(x, {0xD0, 0xC0}); break;        // rol al, 1
+        case IN_RRCA: emit(x, {0xD0, 0xC8}); break;        // ror al, 1
+        case IN_RLA:  emit(x, {0xD0, 0xD0}); break;        // rcl al, 1
+        default:      emit(x, {0xD0, 0xD8}); break;        // rcr al, 1
+    }
+
+    emit(x, {0x0F, 0x92, 0xC1});                            // setc cl
+    emit_store8(x, X_EAX, JIT_R8(RT_A));
+    emit_flags_zc(x, false);
+}
+
+static void emit_cb(jit_emitter *x, const jit_entry *e) {
+    static const reg_type regs[] = {RT_B, RT_C, RT_D, RT_E, RT_H, RT_L, RT_HL, RT_A};
+
+    u8 cb = e->decoded.operand & 0xFF;
+    reg_type reg = regs[cb & 0b111];
+    u8 bit = (cb >> 3) & 0b111;
+    u8 mask = 1 << bit;
+
+    emit_serial(x);
+
+    if (reg == RT_HL) {
+        // BIT n, (HL)
+        emit_address(x, RT_HL);
+        emit_read(x);
+        jit_defer(x, 3);
+        emit_bit(x, 0, mask);
+        return;
+    }
+
+    jit_defer(x, 1);
+
+    u32 off = JIT_R8(reg);
+
+    switch (cb >> 6) {
+        case 0:
+            // RLC, RRC, RL, RR, SLA, SRA, SWAP, SRL
+            if (bit == 2 || bit == 3) {
+                emit_carry_in(x);
+            }
+
+            emit_load8(x, X_EAX, off);
+
+            switch (bit) {
+                case 0: emit(x, {0xD0, 0xC0}); break;      // rol al, 1
+                case 1: emit(x, {0xD0, 0xC8}); break;      // ror al, 1
+                case 2: emit(x, {0xD0, 0xD0}); break;      // rcl al, 1
+                case 3: emit(x, {0xD0, 0xD8}); break;      // rcr al, 1
+                case 4: emit(x, {0xD0, 0xE0}); break;      // shl al, 1
+                case 5: emit(x, {0xD0, 0xF8}); break;      // sar al, 1
+                case 6: emit(x, {0xC0, 0xC0, 0x04}); break;    // rol al, 4
+                default: emit(x, {0xD0, 0xE8}); break;     // shr al, 1
+            }
+
+            if (bit == 6) {
+                emit(x, {0x31, 0xC9});                      // xor ecx, ecx
+            } else {
+                emit(x, {0x0F, 0x92, 0xC1});                // setc cl
+            }
+
+            emit_store8(x, X_EAX, off);
+            emit(x, {0x84, 0xC0});                          // test al, al
+            emit(x, {0x0F, 0x94, 0xC2});                    // setz dl
+            emit_flags_zc(x, true);
+            break;
+
+        case 1:
+            emit_bit(x, off, mask);
+            break;
+
+        case 2:
+            emit_alu8_imm(x, X_AND, off, ~mask);
+            break;
+
+        default:
+            emit_alu8_imm(x, X_OR, off, mask);
+            break;
+    }
+}
+
+static void emit_pop(jit_emitter *x, const jit_entry *e) {
+    reg_type r1 = e->decoded.inst->reg_1;
+
+    emit_serial(x);
+
+    emit_load16(x, X_EDI, JIT_SP);
+    emit_read(x);
+    emit_inc16(x, JIT_SP, 1);
+
+    if (r1 == RT_AF) {
+        // Low nibble of F always reads as zero
+        emit(x, {0x24, 0xF0});                              // and al, 0xF0
+    }
+
+    emit_store8(x, X_EAX, JIT_R16(r1));
+    jit_defer(x, 1);
+
+    emit_load16(x, X_EDI, JIT_SP);
+    emit_read(x);
+    emit_inc16(x, JIT_SP, 1);
+    emit_store8(x, X_EAX, JIT_R16(r1) + 1);
+    jit_defer(x, 1);
+}
+
+static void emit_push_reg(jit_emitter *x, const jit_entry *e, u32 n) {
+    u32 off = JIT_R16(e->decoded.inst->reg_1);
+
+    emit_serial(x);
+    jit_defer(x, 1);
+
+    emit_load8(x, X_ESI, off + 1);
+    emit_push(x);
+    jit_defer(x, 1);
+
+    emit_load8(x, X_ESI, off);
+    emit_push(x);
+    jit_defer(x, 1);
+
+    emit_store_end(x, e, n);
+}
+
+// JP, JR, CALL, RST, RET. Returns false when the block ends here.
+static bool emit_branch(jit_emitter *x, const jit_entry *e, u32 n) {
+    const instruction *inst = e->decoded.inst;
+    u16 target = e->decoded.operand;
+
+    emit_serial(x);
+
+    if (inst->type == IN_JP && inst->mode == AM_R) {
+        // JP HL
+        jit_defer(x, 1);
+        emit_flush(x);
+        emit_load16(x, X_EAX, JIT_R16(RT_HL));
+        emit_mem(x, {0x66, 0x89}, X_EAX, JIT_PC);           // mov [pc], ax
+        emit_idle_check(x, e);
+        emit_exit(x, n);
+        return false;
+    }
+
+    if (inst->type == IN_JR) {
+        target = e->next_pc + (int8_t)(e->decoded.operand & 0xFF);
+    } else if (inst->type == IN_RST) {
+        target = inst->param;
+    } else if (inst->type == IN_RET && inst->cond != CT_NONE) {
+        // Condition check
+        jit_defer(x, 1);
+    }
+
+    u8 *skip = inst->cond != CT_NONE ? emit_cond_skip(x, inst->cond) : nullptr;
+
+    // The taken path leaves, what follows is the not taken one
+    // The segment keeps the taken cycles, the check before covers both paths
+    u32 deferred = x->deferred;
+    bool written = x->written;
+
+    switch (inst->type) {
+        case IN_JP:
+        case IN_JR:
+            emit_jump(x, e, target, n);
+            break;
+
+        case IN_CALL:
+        case IN_RST:
+            emit_call_taken(x, e, target, n);
+            break;
+
+        default:
+            emit_ret_taken(x, e, n);
+            break;
+    }
+
+    x->deferred = deferred;
+    x->written = written;
+
+    if (skip) {
+        patch32(x, skip);
+    }
+
+    return skip != nullptr;
+}
+
+// Host code for instruction `n` of the block, false when it always leaves
+static bool emit_native(jit_emitter *x, const jit_entry *e, u32 n) {
+    const instruction *inst = e->decoded.inst;
+
+    // The opcode and its immediates
+    jit_defer(x, e->decoded.length);
+
+    switch (inst->type) {
+        case IN_NOP:
+            emit_serial(x);
+            break;
+
+        case IN_LD:
+            emit_ld(x, e, n);
+            break;
+
+        case IN_LDH:
+            emit_serial(x);
+            emit_mov_imm(x, X_EDI, 0xFF00 | (e->decoded.operand & 0xFF));
+
+            if (inst->reg_1 == RT_A) {
+                emit_read(x);
+                emit_store8(x, X_EAX, JIT_R8(RT_A));
+                jit_defer(x, 1);
+            } else {
+                emit_load8(x, X_ESI, JIT_R8(RT_A));
+                emit_write(x);
+                jit_defer(x, 1);
+                emit_store_end(x, e, n);
+            }
+            break;
+
+        case IN_INC:
+        case IN_DEC:
+            emit_inc_dec(x, e, n);
+            break;
+
+        case IN_ADD:
+            if (inst->reg_1 == RT_HL) {
+                emit_add_hl(x, e);
+            } else {
+                emit_alu(x, e);
+            }
+            break;
+
+        case IN_ADC:
+        case IN_SUB:
+        case IN_SBC:
+        case IN_AND:
+        case IN_XOR:
+        case IN_OR:
+        case IN_CP:
+            emit_alu(x, e);
+            break;
+
+        case IN_RLCA:
+        case IN_RRCA:
+        case IN_RLA:
+        case IN_RRA:
+            emit_rotate_a(x, inst->type);
+            break;
+
+        case IN_CPL:
+            emit_serial(x);
+            emit_mem(x, {0xF6}, 2, JIT_R8(RT_A));               // not byte [a]
+            emit_alu8_imm(x, X_OR, JIT_F, 0x60);
+            break;
+
+        case IN_SCF:
+            emit_serial(x);
+            emit_alu8_imm(x, X_AND, JIT_F, 0x8F);
+            emit_alu8_imm(x, X_OR, JIT_F, 0x10);
+            break;
+
+        case IN_CCF:
+            emit_serial(x);
+            emit_alu8_imm(x, X_AND, JIT_F, 0x9F);
+            emit_alu8_imm(x, X_XOR, JIT_F, 0x10);
+            break;
+
+        case IN_DI:
+            emit_serial(x);
+            emit_store8_imm(x, JIT_OFF(gb->cpu.int_master_enabled), 0);
+            break;
+
+        case IN_CB:
+            emit_cb(x, e);
+            break;
+
+        case IN_PUSH:
+            emit_push_reg(x, e, n);
+            break;
+
+        case IN_POP:
+            emit_pop(x, e);
+            break;
+
+        default:
+            return emit_branch(x, e, n);
+    }
+
+    return true;
+}
+
+// Anything else: the opcode handler through jit_exec_inst()
+static void emit_helper(jit_emitter *x, jit_entry *e, u32 n) {
+    emit_flush(x);
+
+    emit(x, {0x48, 0xBF});                                  // mov rdi, imm64
+    emit_u64(x, (u64)e);
+    emit_call(x, (const void *)jit_exec_inst);
+    emit_exit_unless(x, n);
+
+    x->serial = true;
+    emit_budget_check(x, n);
+}
+
+// Translation
+
+static bool ends_block(const instruction *inst) {
+    switch(inst->type) {
+        case IN_JP:
+        case IN_JR:
+        case IN_CALL:
+        case IN_RET:
+            // Not taken, the block goes on
+            return inst->cond == CT_NONE;
+
+        case IN_RETI:
+        case IN_RST:
+        case IN_HALT:
+        case IN_STOP:
+        case IN_EI:
+        case IN_NONE:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+static void jit_translate(jit_block *b, u16 pc, u8 bank) {
+    if (gb->jit.code_used + JIT_BLOCK_BYTES > JIT_CODE_SIZE ||
+        gb->jit.entries_used + JIT_BLOCK_MAX > JIT_MAX_ENTRIES) {
+        cpu_dynarec_flush();
+    }
+
+    u16 region_end = pc < 0x4000 ? 0x3FFF : 0x7FFF;
+    jit_entry *entries = &gb->jit.entries[gb->jit.entries_used];
+    u32 count = 0;
+    u16 addr = pc;
+
+    while (count < JIT_BLOCK_MAX) {
+        u8 opcode = bus_read(addr);
+        const instruction *inst = instruction_by_opcode(opcode);
+        u8 length = 1 + inst_immediate_bytes(inst->mode);
+
+        if (addr + length - 1 > region_end) {
+            // Operands cross into another region
+            break;
+        }
+
+        jit_entry *e = &entries[count++];
+        e->decoded.inst = inst;
+        e->decoded.proc = cpu_op_handler(opcode);
+        e->decoded.opcode = opcode;
+        e->decoded.length = length;
+        e->decoded.operand = 0;
+
+        if (length > 1) {
+            e->decoded.operand = bus_read(addr + 1);
+        }
+
+        if (length > 2) {
+            e->decoded.operand |= bus_read(addr + 2) << 8;
+        }
+
+        e->decoded.valid = true;
+        e->pc = addr;
+        e->next_pc = addr + length;
+
+        addr += length;
+
+        if (ends_block(inst) || addr > region_end) {
+            break;
+        }
+    }
+
+    b->code = nullptr;
+    b->bank = bank;
+
+    if (!count) {
+        return;
+    }
+
+    u8 *start = gb->jit.code + gb->jit.code_used;
+
+    if (!jit_protect(start, JIT_BLOCK_BYTES, true)) {
+        return;
+    }
+
+    gb->jit.entries_used += count;
+
+    jit_emitter x = {};
+    x.p = start;
+    x.serial = true;
+
+    emit(&x, {0x53});                                       // push rbx (keeps the stack 16-byte aligned)
+    emit(&x, {0x48, 0x89, 0xFB});                           // mov rbx, rdi
+    emit_budget_check(&x, 0);
+
+    bool falls_through = true;
+    u32 emitted = 0;
+
+    for (u32 i = 0; i < count && falls_through; i++, emitted++) {
+        jit_entry *e = &entries[i];
+
+        // Long runs without a store get checks of their own, the budget to
+        // the next timer/PPU event is often shorter than the whole block
+        if (x.segment >= JIT_SEGMENT_CYCLES) {
+            emit_flush(&x);
+            emit_budget_check(&x, i);
+        }
+
+        if (jit_native(e->decoded.inst, e->decoded.operand)) {
+            falls_through = emit_native(&x, e, i + 1);
+        } else {
+            emit_helper(&x, e, i + 1);
+        }
+    }
+
+    if (falls_through) {
+        emit_flush(&x);
+        emit_store16_imm(&x, JIT_PC, entries[count - 1].next_pc);
+        emit_exit(&x, count);
+    }
+
+    jit_end_segment(&x);
+
+    // Slow paths: the instructions of a check that failed one by one like
+    // cpu_step() runs them, then back to the next check
+    for (u32 c = 0; c < x.check_count; c++) {
+        u32 first = x.checks[c].first;
+        u32 last = c + 1 < x.check_count ? x.checks[c + 1].first : emitted;
+
+        patch32(&x, x.checks[c].slow);
+
+        emit(&x, {0x48, 0xBF});                             // mov rdi, imm64
+        emit_u64(&x, (u64)&entries[first]);
+        emit_mov_imm(&x, X_ESI, last - first);
+        emit_call(&x, (const void *)jit_exec_slow);
+
+        u8 *leave = nullptr;
+
+        if (c + 1 < x.check_count) {
+            emit(&x, {0xA8, 0x01});                         // test al, 1
+            leave = emit_jcc8(&x, 0x75);                    // jnz
+            emit(&x, {0xE9});                               // jmp rel32
+            emit_u32(&x, (u32)(x.checks[c + 1].at - (x.p + 4)));
+            patch8(&x, leave);
+        }
+
+        emit(&x, {0xD1, 0xE8});                             // shr eax, 1
+        emit(&x, {0x05});                                   // add eax, first
+        emit_u32(&x, first);
+        emit(&x, {0x5B, 0xC3});                             // pop rbx; ret
+    }
+
+    gb->jit.code_used += x.p - start;
+
+    if (!jit_protect(start, JIT_BLOCK_BYTES, false)) {
+        return;
+    }
+
+    b->code = start;
+    b->count = count;
+}
+
+static jit_block *jit_lookup(u16 pc) {
+    if (pc < 0x4000) {
+        return &gb->jit.rom0[pc];
+    }
+
+    if (pc < 0x8000) {
+        return &gb->jit.romx[pc - 0x4000];
+    }
+
+    return nullptr;
+}
+
+// cpu_step() between instructions, what a block can't do: service an
+// interrupt, finish EI, or stop short of its last instruction
+static bool jit_can_enter(const jit_block *b, u32 steps) {
+    cpu_context *cpu = &gb->cpu;
+
+    if (steps < b->count || cpu->enabling_ime) {
+        return false;
+    }
+
+    return !(cpu->int_master_enabled && (cpu->int_flags & cpu->ie_register & 0x1F));
+}
+
+bool cpu_dynarec_exec(u32 steps) {
+    if (!jit_init()) {
+        for (u32 i = 0; i < steps; i++) {
+            if (!cpu_step()) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    while (steps) {
+        jit_block *b = gb->cpu.halted ? nullptr : jit_lookup(gb->cpu.regs.pc);
+
+        if (b) {
+            u8 bank = gb->cpu.regs.pc >= 0x4000 ? cart_get_context()->rom_bank_value : 0;
+
+            bool stale = !b->code || b->bank != bank;
+
+            if (stale && steps < JIT_BLOCK_MAX) {
+                // Close to the end of the steps cpu_step() would run most
+                // of a new block, and one at each of the next PCs would be
+                // translated too
+                b = nullptr;
+            } else if (stale) {
+                jit_translate(b, gb->cpu.regs.pc, bank);
+            }
+        }
+
+        if (!b || !b->code || gb->jit.disabled || !jit_can_enter(b, steps)) {
+            // Halted, running from RAM, or cpu_step() has to take this one
+            if (!cpu_step()) {
+                return false;
+            }
+
+            steps--;
+            continue;
+        }
+
+        // Translated code reads and writes F directly
+        cpu_flags_sync(&gb->cpu);
+
+        gb->jit.exit_block = false;
+        gb->jit.check = false;
+
+        steps -= ((jit_fn)b->code)(gb);
+    }
+
+    return true;
+}
+
+#else
+
+// No translator for this host
+
+bool cpu_dynarec_exec(u32 steps) {
+    for (u32 i = 0; i < steps; i++) {
+        if (!cpu_step()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void cpu_dynarec_bank_switch() {
+}
+
+void cpu_dynarec_flush() {
+}
+
+void cpu_dynarec_free() {
+}
+
+#endif
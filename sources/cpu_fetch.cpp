@@ -1,172 +1,136 @@
 #include <./../headers/cpu.hpp>
 #include <./../headers/bus.hpp>
 #include <./../headers/main.hpp>
-
-extern cpu_context ctx;
+#include <./../headers/cpu_fetch.hpp>
+#include <./../headers/gameboy.hpp>
 
 void fetch_data() {
-    ctx.mem_dest = 0;
-    ctx.dest_is_mem = false;
+    gb->cpu.mem_dest = 0;
+    gb->cpu.dest_is_mem = false;
 
-    if (ctx.current_inst == nullptr) {
+    if (gb->cpu.current_inst == nullptr) {
         return;
     }
 
-    switch(ctx.current_inst->mode){
+    switch(gb->cpu.current_inst->mode){
         case AM_IMP: return;
 
         case AM_R:
-            ctx.fetched_data = cpu_read_reg(ctx.current_inst->reg_1);
+            gb->cpu.fetched_data = cpu_read_reg(gb->cpu.current_inst->reg_1);
             return;
 
         case AM_R_R:
-            ctx.fetched_data = cpu_read_reg(ctx.current_inst->reg_2);
+            gb->cpu.fetched_data = cpu_read_reg(gb->cpu.current_inst->reg_2);
             return;
         
 
         case AM_R_D8:
-            ctx.fetched_data = bus_read(ctx.regs.pc);
-            emu_cycles(1);
-            ctx.regs.pc++;
+            gb->cpu.fetched_data = fetch_imm8(&gb->cpu);
             return;
 
         case AM_R_D16:
-        case AM_D16: {
-            u16 lo = bus_read(ctx.regs.pc);
-            emu_cycles(1);
-
-            u16 hi = bus_read(ctx.regs.pc + 1);
-            emu_cycles(1);
-
-            ctx.fetched_data = lo | (hi << 8);
-            ctx.regs.pc += 2;
+        case AM_D16:
+            gb->cpu.fetched_data = fetch_imm16(&gb->cpu);
             return;
-        }
 
         case AM_MR_R:
-            ctx.fetched_data = cpu_read_reg(ctx.current_inst->reg_2);
-            ctx.mem_dest = cpu_read_reg(ctx.current_inst->reg_1);
-            ctx.dest_is_mem = true;
+            gb->cpu.fetched_data = cpu_read_reg(gb->cpu.current_inst->reg_2);
+            gb->cpu.mem_dest = cpu_read_reg(gb->cpu.current_inst->reg_1);
+            gb->cpu.dest_is_mem = true;
 
-            if (ctx.current_inst->reg_1 == RT_C) 
-                ctx.mem_dest |= 0xFF00;
+            if (gb->cpu.current_inst->reg_1 == RT_C) 
+                gb->cpu.mem_dest |= 0xFF00;
 
             return; 
 
         case AM_R_MR: {
-            u16 addr = cpu_read_reg(ctx.current_inst->reg_2);
+            u16 addr = cpu_read_reg(gb->cpu.current_inst->reg_2);
 
-            if (ctx.current_inst->reg_2 == RT_C){
+            if (gb->cpu.current_inst->reg_2 == RT_C){
                 addr |= 0xFF00;
             }
 
-            ctx.fetched_data = bus_read(addr);
+            gb->cpu.fetched_data = bus_read(addr);
             emu_cycles(1);
             return;
         }
 
         case AM_R_HLI:
-            ctx.fetched_data = bus_read(cpu_read_reg(ctx.current_inst->reg_2)); 
+            gb->cpu.fetched_data = bus_read(cpu_read_reg(gb->cpu.current_inst->reg_2)); 
             emu_cycles(1);
             cpu_set_reg(RT_HL, cpu_read_reg(RT_HL) + 1);
             return;
 
         case AM_R_HLD:
-            ctx.fetched_data = bus_read(cpu_read_reg(ctx.current_inst->reg_2)); 
+            gb->cpu.fetched_data = bus_read(cpu_read_reg(gb->cpu.current_inst->reg_2)); 
             emu_cycles(1);
             cpu_set_reg(RT_HL, cpu_read_reg(RT_HL) - 1);
             return;
 
         case AM_HLI_R:
-            ctx.fetched_data = cpu_read_reg(ctx.current_inst->reg_2);
-            ctx.mem_dest = cpu_read_reg(ctx.current_inst->reg_1);
-            ctx.dest_is_mem = true;
+            gb->cpu.fetched_data = cpu_read_reg(gb->cpu.current_inst->reg_2);
+            gb->cpu.mem_dest = cpu_read_reg(gb->cpu.current_inst->reg_1);
+            gb->cpu.dest_is_mem = true;
             cpu_set_reg(RT_HL, cpu_read_reg(RT_HL) + 1);
             break;
 
         case AM_HLD_R:
-            ctx.fetched_data = cpu_read_reg(ctx.current_inst->reg_2);
-            ctx.mem_dest = cpu_read_reg(ctx.current_inst->reg_1);
-            ctx.dest_is_mem = true;
+            gb->cpu.fetched_data = cpu_read_reg(gb->cpu.current_inst->reg_2);
+            gb->cpu.mem_dest = cpu_read_reg(gb->cpu.current_inst->reg_1);
+            gb->cpu.dest_is_mem = true;
             cpu_set_reg(RT_HL, cpu_read_reg(RT_HL) - 1);
             return;
 
         case AM_R_A8:
-            ctx.fetched_data = bus_read(ctx.regs.pc);
-            emu_cycles(1);
-            ctx.regs.pc++;
+            gb->cpu.fetched_data = fetch_imm8(&gb->cpu);
             return;
 
         case AM_A8_R:
-            ctx.mem_dest = bus_read(ctx.regs.pc) | 0xFF00;
-            ctx.dest_is_mem = true;
-            emu_cycles(1);
-            ctx.regs.pc++;
+            gb->cpu.mem_dest = fetch_imm8(&gb->cpu) | 0xFF00;
+            gb->cpu.dest_is_mem = true;
             return;
 
         case AM_HL_SPR:
-            ctx.fetched_data = bus_read(ctx.regs.pc);
-            emu_cycles(1);
-            ctx.regs.pc++;
+            gb->cpu.fetched_data = fetch_imm8(&gb->cpu);
             return;
 
         case AM_D8:
-            ctx.fetched_data = bus_read(ctx.regs.pc);
-            emu_cycles(1);
-            ctx.regs.pc++;
+            gb->cpu.fetched_data = fetch_imm8(&gb->cpu);
             return;
 
         case AM_A16_R:
-        case AM_D16_R: {
-                u16 lo = bus_read(ctx.regs.pc);
-                emu_cycles(1);
-    
-                u16 hi = bus_read(ctx.regs.pc + 1);
-                emu_cycles(1);
-    
-                ctx.mem_dest = lo | (hi << 8);
-                ctx.dest_is_mem = true;
-    
-                ctx.regs.pc += 2;
-                ctx.fetched_data = cpu_read_reg(ctx.current_inst->reg_2);
-                return;  
-        } 
+        case AM_D16_R:
+            gb->cpu.mem_dest = fetch_imm16(&gb->cpu);
+            gb->cpu.dest_is_mem = true;
+            gb->cpu.fetched_data = cpu_read_reg(gb->cpu.current_inst->reg_2);
+            return;
 
         case AM_MR_D8:
-            ctx.fetched_data = bus_read(ctx.regs.pc);
-            emu_cycles(1);
-            ctx.regs.pc++;
+            gb->cpu.fetched_data = fetch_imm8(&gb->cpu);
 
-            ctx.mem_dest = cpu_read_reg(ctx.current_inst->reg_1);
-            ctx.dest_is_mem = true;
+            gb->cpu.mem_dest = cpu_read_reg(gb->cpu.current_inst->reg_1);
+            gb->cpu.dest_is_mem = true;
             return;
 
         case AM_MR:
-            ctx.mem_dest = cpu_read_reg(ctx.current_inst->reg_1);
-            ctx.dest_is_mem = true;
-            ctx.fetched_data = bus_read(cpu_read_reg(ctx.current_inst->reg_1));
+            gb->cpu.mem_dest = cpu_read_reg(gb->cpu.current_inst->reg_1);
+            gb->cpu.dest_is_mem = true;
+            gb->cpu.fetched_data = bus_read(cpu_read_reg(gb->cpu.current_inst->reg_1));
             emu_cycles(1);
             return;
 
         
         case AM_R_A16: {
-            u16 lo = bus_read(ctx.regs.pc);
-            emu_cycles(1);
-
-            u16 hi = bus_read(ctx.regs.pc + 1);
-            emu_cycles(1);
-
-            u16 addr = lo | (hi << 8);
+            u16 addr = fetch_imm16(&gb->cpu);
 
-            ctx.regs.pc += 2;
-            ctx.fetched_data = bus_read(addr);
+            gb->cpu.fetched_data = bus_read(addr);
             emu_cycles(1);
 
             return;
         }
 
         default: 
-        printf("Unkown address mode %d\n", ctx.current_inst->mode);
+        printf("Unkown address mode %d\n", gb->cpu.current_inst->mode);
         exit(-7);
         return;
         
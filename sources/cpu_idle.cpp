@@ -0,0 +1,294 @@
+#include <./../headers/cpu_idle.hpp>
+#include <./../headers/cpu.hpp>
+#include <./../headers/cpu_flags.hpp>
+#include <./../headers/inst_table.hpp>
+#include <./../headers/bus.hpp>
+#include <./../headers/cart.hpp>
+#include <./../headers/main.hpp>
+#include <./../headers/gameboy.hpp>
+#include <string.h>
+
+// A loop qualifies when it is a straight run of ROM instructions closed by
+// the backward JR/JP, with no writes, calls or stack use, and only reads from
+// memory that nothing but the CPU or a timer/PPU event can change. Other
+// branches in the body are conditional exits that fall through while it spins.
+//
+// Once an iteration ran back to back with the previous one, saw the same
+// memory (no timer/PPU event since the previous one started) and ended with
+// the registers it started from, every further iteration does exactly the
+// same until a value it reads changes. That can't happen before
+// emu_idle_cycles() runs out, so the whole iterations that fit are skipped by
+// advancing time alone, which leaves the same state as running them.
+
+#define IDLE_MAX_BYTES  16          // Longest loop body, branch included
+
+typedef enum {
+    IL_NEW,
+    IL_LOOP,
+    IL_REJECTED
+} idle_loop_state;
+
+// Address registers of the indirect reads in a loop
+typedef enum {
+    IR_BC = 1,
+    IR_DE = 2,
+    IR_HL = 4,
+    IR_C  = 8                       // LD A,(C) reads 0xFF00 + C
+} idle_indirect;
+
+void cpu_idle_init() {
+    memset(&gb->idle, 0, sizeof(gb->idle));
+}
+
+void cpu_idle_set_enabled(bool e) {
+    gb->idle_skip = e;
+}
+
+bool cpu_idle_enabled() {
+    return gb->idle_skip;
+}
+
+const cpu_idle_stats *cpu_idle_get_stats() {
+    return &gb->idle.stats;
+}
+
+void cpu_idle_print_stats() {
+    printf("Idle loops (%s): %u found, %llu skips, %llu iterations (%llu M-cycles) skipped\n",
+        cart_get_context()->header ? cart_get_context()->header->title : "-",
+        gb->idle.stats.loops, (unsigned long long)gb->idle.stats.skips,
+        (unsigned long long)gb->idle.stats.skipped_iterations,
+        (unsigned long long)gb->idle.stats.skipped_cycles);
+}
+
+// Memory that only changes through a CPU write or at a timer/PPU event
+static bool idle_addr_stable(u16 address) {
+    return address < 0xA000 ||                      // ROM, VRAM
+        BETWEEN(address, 0xC000, 0xDFFF) ||         // WRAM
+        address == 0xFF0F ||                        // IF
+        BETWEEN(address, 0xFF40, 0xFF4B) ||         // LCD, LY and STAT move with the PPU
+        address >= 0xFF80;                          // HRAM, IE
+}
+
+// Bit of reg_type `rt` in the written registers mask
+#define REG_BIT(rt) (1 << (rt))
+
+// Fills in the loop closed by the branch at `from`, or rejects it. Cycles are
+// counted the way the opcode handlers charge them.
+static void idle_analyze(idle_loop *l, u16 from) {
+    l->state = IL_REJECTED;
+
+    const instruction *br = &inst_table[bus_read(from)];
+    u8 br_length = 1 + inst_immediate_bytes(br->mode);
+
+    if (br->type == IN_JR) {
+        l->target = from + 2 + (int8_t)bus_read(from + 1);
+    } else if (br->type == IN_JP && br->mode == AM_D16) {
+        l->target = bus_read16(from + 1);
+    } else {
+        return;
+    }
+
+    if (l->target >= from || from + br_length - l->target > IDLE_MAX_BYTES ||
+        (l->target < 0x4000) != (from < 0x4000)) {
+        return;
+    }
+
+    // Fetch and the taken branch
+    u32 cycles = br_length + 1;
+    u32 written = 0;
+    u8 indirect = 0;
+    u16 pc = l->target;
+
+    while (pc < from) {
+        u8 opcode = bus_read(pc);
+        const instruction *in = &inst_table[opcode];
+        u8 length = 1 + inst_immediate_bytes(in->mode);
+
+        cycles += length;
+
+        switch(in->type) {
+            case IN_NOP:
+            case IN_RLCA:
+            case IN_RRCA:
+            case IN_RLA:
+            case IN_RRA:
+            case IN_DAA:
+            case IN_CPL:
+            case IN_SCF:
+            case IN_CCF:
+                break;
+
+            case IN_JR:
+            case IN_JP:
+                // Exits only, they fall through while the loop spins
+                if (in->cond == CT_NONE || in->mode == AM_R) {
+                    return;
+                }
+                break;
+
+            case IN_INC:
+            case IN_DEC:
+                if (in->mode != AM_R || in->reg_1 >= RT_AF) {
+                    return;
+                }
+
+                written |= REG_BIT(in->reg_1);
+                break;
+
+            case IN_LD:
+            case IN_ADD:
+            case IN_ADC:
+            case IN_SUB:
+            case IN_SBC:
+            case IN_AND:
+            case IN_XOR:
+            case IN_OR:
+            case IN_CP:
+                if (in->reg_1 >= RT_AF || (in->type != IN_LD && in->reg_1 != RT_A)) {
+                    return;
+                }
+
+                if (in->mode == AM_R_R) {
+                    if (in->reg_2 >= RT_AF) {
+                        return;
+                    }
+                } else if (in->mode == AM_R_MR) {
+                    switch(in->reg_2) {
+                        case RT_BC: indirect |= IR_BC; break;
+                        case RT_DE: indirect |= IR_DE; break;
+                        case RT_HL: indirect |= IR_HL; break;
+                        case RT_C:  indirect |= IR_C; break;
+                        default: return;
+                    }
+
+                    cycles++;
+                } else if (in->mode == AM_R_A16) {
+                    if (!idle_addr_stable(bus_read16(pc + 1))) {
+                        return;
+                    }
+
+                    cycles++;
+                } else if (in->mode != AM_R_D8) {
+                    return;
+                }
+
+                written |= REG_BIT(in->reg_1);
+                break;
+
+            case IN_LDH:
+                if (in->mode != AM_R_A8 || !idle_addr_stable(0xFF00 | bus_read(pc + 1))) {
+                    return;
+                }
+
+                cycles++;
+                break;
+
+            case IN_CB: {
+                u8 cb = bus_read(pc + 1);
+
+                // BIT only, the other CB ops write their operand
+                if ((cb >> 6) != 1) {
+                    return;
+                }
+
+                if ((cb & 0b111) == 6) {
+                    indirect |= IR_HL;
+                    cycles += 3;
+                } else {
+                    cycles += 1;
+                }
+            } break;
+
+            default:
+                return;
+        }
+
+        pc += length;
+    }
+
+    if (pc != from) {
+        // Last instruction overlaps the branch
+        return;
+    }
+
+    // Indirect addresses have to stay put for the whole iteration
+    if (((indirect & IR_BC) && (written & (REG_BIT(RT_B) | REG_BIT(RT_C)))) ||
+        ((indirect & IR_DE) && (written & (REG_BIT(RT_D) | REG_BIT(RT_E)))) ||
+        ((indirect & IR_HL) && (written & (REG_BIT(RT_H) | REG_BIT(RT_L)))) ||
+        ((indirect & IR_C) && (written & REG_BIT(RT_C)))) {
+        return;
+    }
+
+    l->cycles = cycles;
+    l->indirect = indirect;
+    l->state = IL_LOOP;
+}
+
+static bool idle_indirect_stable(idle_loop *l) {
+    return (!(l->indirect & IR_BC) || idle_addr_stable(gb->cpu.regs.bc)) &&
+        (!(l->indirect & IR_DE) || idle_addr_stable(gb->cpu.regs.de)) &&
+        (!(l->indirect & IR_HL) || idle_addr_stable(gb->cpu.regs.hl)) &&
+        (!(l->indirect & IR_C) || idle_addr_stable(0xFF00 | gb->cpu.regs.c));
+}
+
+void cpu_idle_branch(u16 from) {
+    if (!gb->idle_skip || from >= 0x8000) {
+        return;
+    }
+
+    u8 bank = from >= 0x4000 ? cart_get_context()->rom_bank_value : 0;
+    idle_loop *l = &gb->idle.loops[(from ^ bank) & (IDLE_TABLE_SIZE - 1)];
+
+    if (l->state == IL_NEW || l->pc != from || l->bank != bank) {
+        memset(l, 0, sizeof(*l));
+        l->pc = from;
+        l->bank = bank;
+
+        idle_analyze(l, from);
+    }
+
+    // An interrupt taken at the branch also lands here
+    if (l->state != IL_LOOP || gb->cpu.regs.pc != l->target) {
+        return;
+    }
+
+    cpu_flags_sync(&gb->cpu);
+
+    u64 now = emu_get_context()->ticks;
+    u32 idle_cycles = emu_idle_cycles();
+
+    // Back to back with the previous iteration, same memory, same registers
+    bool repeat = now - l->ticks == l->cycles * 4u && now <= l->stable_until &&
+        !memcmp(&l->regs, &gb->cpu.regs, sizeof(cpu_regs));
+
+    l->regs = gb->cpu.regs;
+    l->ticks = now;
+    l->stable_until = now + idle_cycles * 4;
+
+    if (!repeat || !idle_indirect_stable(l)) {
+        return;
+    }
+
+    // A pending interrupt or EI would change the flow at the next boundary
+    if (gb->cpu.enabling_ime || (gb->cpu.int_master_enabled && (gb->cpu.int_flags & gb->cpu.ie_register))) {
+        return;
+    }
+
+    u32 iterations = idle_cycles / l->cycles;
+
+    if (!iterations) {
+        return;
+    }
+
+    emu_skip_cycles(iterations * l->cycles);
+    l->ticks = emu_get_context()->ticks;
+
+    if (!l->skipped) {
+        l->skipped = true;
+        gb->idle.stats.loops++;
+    }
+
+    gb->idle.stats.skips++;
+    gb->idle.stats.skipped_iterations += iterations;
+    gb->idle.stats.skipped_cycles += iterations * l->cycles;
+}
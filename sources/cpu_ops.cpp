@@ -0,0 +1,513 @@
+#include <./../headers/cpu.hpp>
+#include <./../headers/cpu_fetch.hpp>
+#include <./../headers/cpu_flags.hpp>
+#include <./../headers/inst_table.hpp>
+#include <./../headers/stack.hpp>
+#include <./../headers/dbg.hpp>
+#include <utility>
+
+// Per-opcode handlers generated from inst_table. Each one is fetch_data()
+// followed by the cpu_proc.cpp processor, with the switches on addressing
+// mode, register and condition resolved at compile time. Bus accesses and
+// emu_cycles() calls stay in the same order as the generic path.
+
+// Registers
+
+template <reg_type R>
+static inline u16 reg_read(cpu_context *ctx) {
+    if constexpr (R == RT_A) return ctx->regs.a;
+    else if constexpr (R == RT_F) return cpu_flags(ctx);
+    else if constexpr (R == RT_B) return ctx->regs.b;
+    else if constexpr (R == RT_C) return ctx->regs.c;
+    else if constexpr (R == RT_D) return ctx->regs.d;
+    else if constexpr (R == RT_E) return ctx->regs.e;
+    else if constexpr (R == RT_H) return ctx->regs.h;
+    else if constexpr (R == RT_L) return ctx->regs.l;
+    else if constexpr (R == RT_AF) { cpu_flags_sync(ctx); return ctx->regs.af; }
+    else if constexpr (R == RT_BC) return ctx->regs.bc;
+    else if constexpr (R == RT_DE) return ctx->regs.de;
+    else if constexpr (R == RT_HL) return ctx->regs.hl;
+    else if constexpr (R == RT_PC) return ctx->regs.pc;
+    else if constexpr (R == RT_SP) return ctx->regs.sp;
+    else return 0;
+}
+
+template <reg_type R>
+static inline void reg_write(cpu_context *ctx, u16 val) {
+    if constexpr (R == RT_A) ctx->regs.a = val & 0xFF;
+    else if constexpr (R == RT_F) cpu_flags_set(ctx, val & 0xFF);
+    else if constexpr (R == RT_B) ctx->regs.b = val & 0xFF;
+    else if constexpr (R == RT_C) ctx->regs.c = val & 0xFF;
+    else if constexpr (R == RT_D) ctx->regs.d = val & 0xFF;
+    else if constexpr (R == RT_E) ctx->regs.e = val & 0xFF;
+    else if constexpr (R == RT_H) ctx->regs.h = val & 0xFF;
+    else if constexpr (R == RT_L) ctx->regs.l = val & 0xFF;
+    else if constexpr (R == RT_AF) { cpu_flags_set(ctx, val & 0xFF); ctx->regs.af = val; }
+    else if constexpr (R == RT_BC) ctx->regs.bc = val;
+    else if constexpr (R == RT_DE) ctx->regs.de = val;
+    else if constexpr (R == RT_HL) ctx->regs.hl = val;
+    else if constexpr (R == RT_PC) ctx->regs.pc = val;
+    else if constexpr (R == RT_SP) ctx->regs.sp = val;
+}
+
+// 8-bit access for CB operands, RT_HL means (HL)
+
+template <reg_type R>
+static inline u8 reg_read8(cpu_context *ctx) {
+    if constexpr (R == RT_HL) return bus_read(reg_read<RT_HL>(ctx));
+    else return reg_read<R>(ctx);
+}
+
+template <reg_type R>
+static inline void reg_write8(cpu_context *ctx, u8 val) {
+    if constexpr (R == RT_HL) bus_write(reg_read<RT_HL>(ctx), val);
+    else reg_write<R>(ctx, val);
+}
+
+// Eager update of some flags, the others keep their current value
+static inline void set_flags(cpu_context *ctx, int z, int n, int h, int c) {
+    cpu_flags_sync(ctx);
+
+    if (z != -1) BIT_SET(ctx->regs.f, 7, z);
+    if (n != -1) BIT_SET(ctx->regs.f, 6, n);
+    if (h != -1) BIT_SET(ctx->regs.f, 5, h);
+    if (c != -1) BIT_SET(ctx->regs.f, 4, c);
+}
+
+template <cond_type C>
+static inline bool check_cond(cpu_context *ctx) {
+    if constexpr (C == CT_NONE) return true;
+    else if constexpr (C == CT_C) return CPU_FLAG_C;
+    else if constexpr (C == CT_NC) return !CPU_FLAG_C;
+    else if constexpr (C == CT_Z) return CPU_FLAG_Z;
+    else return !CPU_FLAG_Z;
+}
+
+constexpr bool is_16_bit(reg_type rt) {
+    return rt >= RT_AF;
+}
+
+// Operand fetch (fetch_data)
+
+template <u8 OP>
+static inline void op_fetch(cpu_context *ctx) {
+    constexpr instruction inst = inst_table[OP];
+    constexpr addr_mode mode = inst.mode;
+
+    ctx->mem_dest = 0;
+    ctx->dest_is_mem = false;
+
+    if constexpr (mode == AM_IMP) {
+        return;
+    } else if constexpr (mode == AM_R) {
+        ctx->fetched_data = reg_read<inst.reg_1>(ctx);
+    } else if constexpr (mode == AM_R_R) {
+        ctx->fetched_data = reg_read<inst.reg_2>(ctx);
+    } else if constexpr (mode == AM_R_D8 || mode == AM_R_A8 || mode == AM_HL_SPR || mode == AM_D8) {
+        ctx->fetched_data = fetch_imm8(ctx);
+    } else if constexpr (mode == AM_R_D16 || mode == AM_D16) {
+        ctx->fetched_data = fetch_imm16(ctx);
+    } else if constexpr (mode == AM_MR_R) {
+        ctx->fetched_data = reg_read<inst.reg_2>(ctx);
+        ctx->mem_dest = reg_read<inst.reg_1>(ctx);
+        ctx->dest_is_mem = true;
+
+        if constexpr (inst.reg_1 == RT_C) {
+            ctx->mem_dest |= 0xFF00;
+        }
+    } else if constexpr (mode == AM_R_MR) {
+        u16 addr = reg_read<inst.reg_2>(ctx);
+
+        if constexpr (inst.reg_2 == RT_C) {
+            addr |= 0xFF00;
+        }
+
+        ctx->fetched_data = bus_read(addr);
+        emu_cycles(1);
+    } else if constexpr (mode == AM_R_HLI || mode == AM_R_HLD) {
+        ctx->fetched_data = bus_read(reg_read<inst.reg_2>(ctx));
+        emu_cycles(1);
+        reg_write<RT_HL>(ctx, reg_read<RT_HL>(ctx) + (mode == AM_R_HLI ? 1 : -1));
+    } else if constexpr (mode == AM_HLI_R || mode == AM_HLD_R) {
+        ctx->fetched_data = reg_read<inst.reg_2>(ctx);
+        ctx->mem_dest = reg_read<inst.reg_1>(ctx);
+        ctx->dest_is_mem = true;
+        reg_write<RT_HL>(ctx, reg_read<RT_HL>(ctx) + (mode == AM_HLI_R ? 1 : -1));
+    } else if constexpr (mode == AM_A8_R) {
+        ctx->mem_dest = fetch_imm8(ctx) | 0xFF00;
+        ctx->dest_is_mem = true;
+    } else if constexpr (mode == AM_A16_R || mode == AM_D16_R) {
+        ctx->mem_dest = fetch_imm16(ctx);
+        ctx->dest_is_mem = true;
+        ctx->fetched_data = reg_read<inst.reg_2>(ctx);
+    } else if constexpr (mode == AM_MR_D8) {
+        ctx->fetched_data = fetch_imm8(ctx);
+        ctx->mem_dest = reg_read<inst.reg_1>(ctx);
+        ctx->dest_is_mem = true;
+    } else if constexpr (mode == AM_MR) {
+        ctx->mem_dest = reg_read<inst.reg_1>(ctx);
+        ctx->dest_is_mem = true;
+        ctx->fetched_data = bus_read(reg_read<inst.reg_1>(ctx));
+        emu_cycles(1);
+    } else if constexpr (mode == AM_R_A16) {
+        u16 addr = fetch_imm16(ctx);
+
+        ctx->fetched_data = bus_read(addr);
+        emu_cycles(1);
+    }
+}
+
+// CB prefix
+
+constexpr reg_type cb_decode_reg(u8 reg) {
+    constexpr reg_type regs[] = {RT_B, RT_C, RT_D, RT_E, RT_H, RT_L, RT_HL, RT_A};
+    return regs[reg & 0b111];
+}
+
+// Operand read plus the cycles of the op, (HL) takes two more
+template <reg_type R>
+static inline u8 cb_operand(cpu_context *ctx) {
+    u8 v = reg_read8<R>(ctx);
+
+    emu_cycles(R == RT_HL ? 3 : 1);
+    return v;
+}
+
+template <u8 CB>
+static void cb_bit(cpu_context *ctx) {
+    constexpr reg_type reg = cb_decode_reg(CB);
+    constexpr u8 mask = 1 << ((CB >> 3) & 0b111);
+
+    cpu_flags_bit(ctx, cb_operand<reg>(ctx) & mask);
+}
+
+template <u8 CB>
+static void cb_res_set(cpu_context *ctx) {
+    constexpr reg_type reg = cb_decode_reg(CB);
+    constexpr u8 mask = 1 << ((CB >> 3) & 0b111);
+
+    u8 v = cb_operand<reg>(ctx);
+
+    if constexpr ((CB >> 6) == 2) {
+        reg_write8<reg>(ctx, v & ~mask);
+    } else {
+        reg_write8<reg>(ctx, v | mask);
+    }
+}
+
+template <u8 CB>
+static void cb_shift(cpu_context *ctx) {
+    constexpr reg_type reg = cb_decode_reg(CB);
+    constexpr u8 op = (CB >> 3) & 0b111;
+
+    u8 reg_val = cb_operand<reg>(ctx);
+    u8 result;
+    bool carry;
+
+    if constexpr (op == 0) {
+        // RLC
+        result = (reg_val << 1) | (reg_val >> 7);
+        carry = reg_val >> 7;
+    } else if constexpr (op == 1) {
+        // RRC
+        result = (reg_val >> 1) | (reg_val << 7);
+        carry = reg_val & 1;
+    } else if constexpr (op == 2) {
+        // RL
+        result = (reg_val << 1) | cpu_flag_c(ctx);
+        carry = reg_val >> 7;
+    } else if constexpr (op == 3) {
+        // RR
+        result = (reg_val >> 1) | (cpu_flag_c(ctx) << 7);
+        carry = reg_val & 1;
+    } else if constexpr (op == 4) {
+        // SLA
+        result = reg_val << 1;
+        carry = reg_val >> 7;
+    } else if constexpr (op == 5) {
+        // SRA
+        result = (int8_t)reg_val >> 1;
+        carry = reg_val & 1;
+    } else if constexpr (op == 6) {
+        // SWAP
+        result = ((reg_val & 0xF0) >> 4) | ((reg_val & 0xF) << 4);
+        carry = false;
+    } else {
+        // SRL
+        result = reg_val >> 1;
+        carry = reg_val & 1;
+    }
+
+    reg_write8<reg>(ctx, result);
+    cpu_flags_lazy(ctx, LF_SHIFT, 0, 0, carry, result);
+}
+
+// Rows 0x00-0x3F shift/rotate, 0x40-0x7F BIT, 0x80-0xBF RES, 0xC0-0xFF SET
+template <u8 CB>
+constexpr IN_PROC cb_handler() {
+    if constexpr ((CB >> 6) == 0) {
+        return cb_shift<CB>;
+    } else if constexpr ((CB >> 6) == 1) {
+        return cb_bit<CB>;
+    } else {
+        return cb_res_set<CB>;
+    }
+}
+
+template <std::size_t... I>
+static constexpr std::array<IN_PROC, 256> make_cb_handlers(std::index_sequence<I...>) {
+    return {{ cb_handler<(u8)I>()... }};
+}
+
+static constexpr std::array<IN_PROC, 256> cb_handlers = make_cb_handlers(std::make_index_sequence<256>{});
+
+IN_PROC cpu_cb_handler(u8 cb) {
+    return cb_handlers[cb];
+}
+
+// Execution (cpu_proc.cpp)
+
+template <cond_type C, bool PUSH_PC>
+static inline void goto_addr(cpu_context *ctx, u16 addr) {
+    if (check_cond<C>(ctx)) {
+
+        if constexpr (PUSH_PC) {
+            emu_cycles(2);
+            stack_push16(ctx->regs.pc);
+        }
+
+        ctx->regs.pc = addr;
+        emu_cycles(1);
+    }
+}
+
+template <cond_type C>
+static inline void op_ret(cpu_context *ctx) {
+    if constexpr (C != CT_NONE) {
+        emu_cycles(1);
+    }
+
+    if (check_cond<C>(ctx)) {
+        u16 lo = stack_pop();
+        emu_cycles(1);
+        u16 hi = stack_pop();
+        emu_cycles(1);
+
+        ctx->regs.pc = (hi << 8) | lo;
+        emu_cycles(1);
+    }
+}
+
+template <u8 OP>
+static inline void op_exec(cpu_context *ctx) {
+    constexpr instruction inst = inst_table[OP];
+    constexpr in_type type = inst.type;
+    constexpr reg_type r1 = inst.reg_1;
+    constexpr reg_type r2 = inst.reg_2;
+
+    if constexpr (type == IN_NOP) {
+        // Do nothing
+    } else if constexpr (type == IN_STOP) {
+        fprintf(stderr, "STOPPING\n\n");
+    } else if constexpr (type == IN_HALT) {
+        ctx->halted = true;
+    } else if constexpr (type == IN_LD) {
+        if constexpr (inst.mode == AM_MR_R || inst.mode == AM_HLI_R || inst.mode == AM_HLD_R ||
+                      inst.mode == AM_A16_R || inst.mode == AM_D16_R || inst.mode == AM_MR_D8) {
+            if constexpr (is_16_bit(r2)) {
+                emu_cycles(1);
+                bus_write16(ctx->mem_dest, ctx->fetched_data);
+            } else {
+                bus_write(ctx->mem_dest, ctx->fetched_data);
+            }
+
+            emu_cycles(1);
+        } else if constexpr (inst.mode == AM_HL_SPR) {
+            u16 src = reg_read<r2>(ctx);
+            u8 hflag = (src & 0xF) + (ctx->fetched_data & 0xF) >= 0x10;
+            u8 cflag = (src & 0xFF) + (ctx->fetched_data & 0xFF) >= 0x100;
+
+            set_flags(ctx, 0, 0, hflag, cflag);
+            reg_write<r1>(ctx, src + (int8_t)ctx->fetched_data);
+        } else {
+            reg_write<r1>(ctx, ctx->fetched_data);
+        }
+    } else if constexpr (type == IN_LDH) {
+        if constexpr (r1 == RT_A) {
+            ctx->regs.a = bus_read(0xFF00 | ctx->fetched_data);
+        } else {
+            bus_write(ctx->mem_dest, ctx->regs.a);
+        }
+
+        emu_cycles(1);
+    } else if constexpr (type == IN_JP) {
+        goto_addr<inst.cond, false>(ctx, ctx->fetched_data);
+    } else if constexpr (type == IN_JR) {
+        goto_addr<inst.cond, false>(ctx, ctx->regs.pc + (int8_t)(ctx->fetched_data & 0xFF));
+    } else if constexpr (type == IN_CALL) {
+        goto_addr<inst.cond, true>(ctx, ctx->fetched_data);
+    } else if constexpr (type == IN_RST) {
+        goto_addr<inst.cond, true>(ctx, inst.param);
+    } else if constexpr (type == IN_RET) {
+        op_ret<inst.cond>(ctx);
+    } else if constexpr (type == IN_RETI) {
+        ctx->int_master_enabled = true;
+        op_ret<inst.cond>(ctx);
+    } else if constexpr (type == IN_DI) {
+        ctx->int_master_enabled = false;
+    } else if constexpr (type == IN_EI) {
+        ctx->enabling_ime = true;
+    } else if constexpr (type == IN_POP) {
+        u16 lo = stack_pop();
+        emu_cycles(1);
+        u16 hi = stack_pop();
+        emu_cycles(1);
+
+        u16 n = (hi << 8) | lo;
+
+        // Low nibble of F always reads as zero
+        reg_write<r1>(ctx, r1 == RT_AF ? n & 0xFFF0 : n);
+    } else if constexpr (type == IN_PUSH) {
+        emu_cycles(1);
+        stack_push((reg_read<r1>(ctx) >> 8) & 0xFF);
+        emu_cycles(1);
+        stack_push(reg_read<r1>(ctx) & 0xFF);
+        emu_cycles(1);
+    } else if constexpr (type == IN_INC || type == IN_DEC) {
+        constexpr int delta = type == IN_INC ? 1 : -1;
+
+        if constexpr (is_16_bit(r1)) {
+            emu_cycles(1);
+        }
+
+        if constexpr (r1 == RT_HL && inst.mode == AM_MR) {
+            u16 hl = reg_read<RT_HL>(ctx);
+            u8 val = bus_read(hl) + delta;
+            bus_write(hl, val);
+
+            cpu_flags_lazy(ctx, type == IN_INC ? LF_INC : LF_DEC, 0, 0, cpu_flag_c(ctx), val);
+        } else if constexpr (is_16_bit(r1)) {
+            // 16-bit INC/DEC leave the flags alone
+            reg_write<r1>(ctx, reg_read<r1>(ctx) + delta);
+        } else {
+            u8 val = reg_read<r1>(ctx) + delta;
+            reg_write<r1>(ctx, val);
+
+            cpu_flags_lazy(ctx, type == IN_INC ? LF_INC : LF_DEC, 0, 0, cpu_flag_c(ctx), val);
+        }
+    } else if constexpr (type == IN_ADD) {
+        u16 a = reg_read<r1>(ctx);
+        u16 b = ctx->fetched_data;
+
+        if constexpr (r1 == RT_SP) {
+            emu_cycles(1);
+            reg_write<r1>(ctx, a + (int8_t)b);
+            set_flags(ctx, 0, 0, (a & 0xF) + (b & 0xF) >= 0x10, (a & 0xFF) + (b & 0xFF) >= 0x100);
+        } else if constexpr (is_16_bit(r1)) {
+            emu_cycles(1);
+            reg_write<r1>(ctx, a + b);
+            set_flags(ctx, -1, 0, (a & 0xFFF) + (b & 0xFFF) >= 0x1000, (u32)a + (u32)b >= 0x10000);
+        } else {
+            u16 val = a + b;
+            reg_write<r1>(ctx, val);
+            cpu_flags_lazy(ctx, LF_ADD, a, b, 0, val);
+        }
+    } else if constexpr (type == IN_ADC) {
+        u16 u = ctx->fetched_data;
+        u16 a = ctx->regs.a;
+        u16 c = CPU_FLAG_C;
+
+        ctx->regs.a = (a + u + c) & 0xFF;
+        cpu_flags_lazy(ctx, LF_ADC, a, u, c, a + u + c);
+    } else if constexpr (type == IN_SUB) {
+        int a = reg_read<r1>(ctx);
+        int b = ctx->fetched_data;
+        u16 val = a - b;
+
+        reg_write<r1>(ctx, val);
+        cpu_flags_lazy(ctx, LF_SUB, a, b, 0, val);
+    } else if constexpr (type == IN_SBC) {
+        int a = reg_read<r1>(ctx);
+        int b = ctx->fetched_data;
+        int c = CPU_FLAG_C;
+        u8 val = b + c;
+
+        reg_write<r1>(ctx, a - val);
+        cpu_flags_lazy(ctx, LF_SBC, a, b, c, 0);
+    } else if constexpr (type == IN_AND) {
+        ctx->regs.a &= ctx->fetched_data;
+        cpu_flags_lazy(ctx, LF_AND, 0, 0, 0, ctx->regs.a);
+    } else if constexpr (type == IN_XOR) {
+        ctx->regs.a ^= ctx->fetched_data & 0xFF;
+        cpu_flags_lazy(ctx, LF_OR, 0, 0, 0, ctx->regs.a);
+    } else if constexpr (type == IN_OR) {
+        ctx->regs.a |= ctx->fetched_data;
+        cpu_flags_lazy(ctx, LF_OR, 0, 0, 0, ctx->regs.a);
+    } else if constexpr (type == IN_CP) {
+        cpu_flags_lazy(ctx, LF_SUB, ctx->regs.a, ctx->fetched_data, 0, 0);
+    } else if constexpr (type == IN_CB) {
+        cb_handlers[ctx->fetched_data & 0xFF](ctx);
+    } else if constexpr (type == IN_RLCA) {
+        u8 c = (ctx->regs.a >> 7) & 1;
+        ctx->regs.a = (ctx->regs.a << 1) | c;
+        set_flags(ctx, 0, 0, 0, c);
+    } else if constexpr (type == IN_RRCA) {
+        u8 c = ctx->regs.a & 1;
+        ctx->regs.a = (ctx->regs.a >> 1) | (c << 7);
+        set_flags(ctx, 0, 0, 0, c);
+    } else if constexpr (type == IN_RLA) {
+        u8 c = (ctx->regs.a >> 7) & 1;
+        ctx->regs.a = (ctx->regs.a << 1) | CPU_FLAG_C;
+        set_flags(ctx, 0, 0, 0, c);
+    } else if constexpr (type == IN_RRA) {
+        u8 c = ctx->regs.a & 1;
+        ctx->regs.a = (ctx->regs.a >> 1) | (CPU_FLAG_C << 7);
+        set_flags(ctx, 0, 0, 0, c);
+    } else if constexpr (type == IN_DAA) {
+        u8 u = 0;
+        int fc = 0;
+
+        if (CPU_FLAG_H || (!CPU_FLAG_N && (ctx->regs.a & 0xF) > 9)) {
+            u = 6;
+        }
+
+        if (CPU_FLAG_C || (!CPU_FLAG_N && ctx->regs.a > 0x99)) {
+            u |= 0x60;
+            fc = 1;
+        }
+
+        ctx->regs.a += CPU_FLAG_N ? -u : u;
+        set_flags(ctx, ctx->regs.a == 0, -1, 0, fc);
+    } else if constexpr (type == IN_CPL) {
+        ctx->regs.a = ~ctx->regs.a;
+        set_flags(ctx, -1, 1, 1, -1);
+    } else if constexpr (type == IN_SCF) {
+        set_flags(ctx, -1, 0, 0, 1);
+    } else if constexpr (type == IN_CCF) {
+        set_flags(ctx, -1, 0, 0, CPU_FLAG_C ^ 1);
+    } else {
+        // IN_NONE and the unused entries
+        inst_get_proc(type)(ctx);
+    }
+}
+
+template <u8 OP>
+static void op_handler(cpu_context *ctx) {
+    op_fetch<OP>(ctx);
+
+    dbg_update();
+    dbg_print();
+
+    op_exec<OP>(ctx);
+}
+
+template <std::size_t... I>
+static constexpr std::array<IN_PROC, 256> make_op_handlers(std::index_sequence<I...>) {
+    return {{ op_handler<(u8)I>... }};
+}
+
+static constexpr std::array<IN_PROC, 256> op_handlers = make_op_handlers(std::make_index_sequence<256>{});
+
+IN_PROC cpu_op_handler(u8 opcode) {
+    return op_handlers[opcode];
+}
@@ -1,4 +1,5 @@
 #include <./../headers/cpu.hpp>
+#include <./../headers/cpu_flags.hpp>
 #include <./../headers/main.hpp>
 #include <./../headers/bus.hpp>
 #include <./../headers/stack.hpp>
@@ -6,6 +7,8 @@
 // Utility functions
 
 void cpu_set_flags(cpu_context *ctx, int8_t z, int8_t n, int8_t h, int8_t c){
+    cpu_flags_sync(ctx);
+
     if (z != -1) {
         BIT_SET(ctx->regs.f, 7, z);
     }
@@ -377,139 +380,8 @@ static void proc_cp(cpu_context *ctx){
 // CB
 
 static void proc_cb(cpu_context *ctx){
-    u8 op = ctx->fetched_data;
-    reg_type reg = decode_reg(op & 0b111);
-    
-    u8 bit = (op >> 3) & 0b111;
-    u8 bit_op = (op >> 6) & 0b11;
-
-    u8 reg_val = cpu_read_reg8(reg);
-
-    emu_cycles(1);
-
-    // Special case
-    if (reg == RT_HL){
-        emu_cycles(2);
-    }
-
-    switch(bit_op){
-        case 1:
-        // BIT
-            cpu_set_flags(ctx, !(reg_val & (1<<bit)), 0, 1, -1);
-            return;
-
-        case 2:
-        // RST                  // FUCKING BUG FUCKING BUGGGGGGGGGGGGGGG FOUND ITTTT
-            
-            //reg_val |= (1 << bit);    
-            reg_val &= ~(1 << bit);
-            
-            cpu_set_reg8(reg, reg_val); 
-            return;
-
-        case 3:
-        // SET
-            reg_val |= (1 << bit);
-            cpu_set_reg8(reg, reg_val); 
-            return;
-        }
-        
-        bool flagC = CPU_FLAG_C;
-
-        switch(bit){
-            case 0: {
-                // RLC (Rotate Left Carry)
-                bool setC = false;
-                u8 result = (reg_val << 1 ) & 0xFF;
-
-                if ((reg_val & (1 << 7)) != 0) {
-                    result |= 1;
-                    setC = true;
-                }
-
-                cpu_set_reg8(reg, result);
-                cpu_set_flags(ctx, result == 0, false, false, setC);
-                return;
-            }
-
-            case 1: {
-                // RRC (Rotate Right Carry)
-                u8 old = reg_val;
-                reg_val >>= 1;
-                reg_val |= (old << 7);
-
-                cpu_set_reg8(reg, reg_val);
-                cpu_set_flags(ctx, !reg_val, false, false, old & 1);
-                return;
-            
-            }
-
-            case 2: {
-                // RL (Rotate Left)
-
-                u8 old = reg_val;
-                reg_val <<= 1;
-                reg_val |= flagC; 
-
-                cpu_set_reg8(reg, reg_val);
-                cpu_set_flags(ctx, !reg_val, false, false, !!(old & 0x80));
-                return;
-
-            }
-
-            case 3: {
-                // RR (Rotate Right)
-                u8 old = reg_val;
-                reg_val >>= 1;
-                
-                reg_val |= (flagC << 7);
-                
-                cpu_set_reg8(reg, reg_val);
-                cpu_set_flags(ctx, !reg_val, false, false, old & 1);
-                return;
-            }
-
-            case 4: {
-                // SLA (Shift Left Arithmetic)
-                u8 old = reg_val;
-                reg_val <<= 1;
-
-                cpu_set_reg8(reg, reg_val);
-                cpu_set_flags(ctx, !reg_val, false, false, !!(old & 0x80));
-                return; 
-            }
-
-            case 5: {
-                // SRA (Shift Right Arithmetic)
-                u8 u = (int8_t)reg_val >> 1; 
-                cpu_set_reg8(reg, u);
-                cpu_set_flags(ctx, !u, false, false, reg_val & 1);
-                return;
-            }
-
-            case 6: {
-                // SWAP
-
-                // Think of it like this:
-                // 0b011001111 -> 0b111100110
-
-                reg_val = ((reg_val & 0xF0) >> 4) | ((reg_val & 0xF) << 4);
-                cpu_set_reg8(reg, reg_val);
-                cpu_set_flags(ctx, reg_val == 0, false, false, false);
-                return;
-            }
-
-            case 7: {
-                // SRL (Shift Right Logical)
-                u8 u = reg_val >> 1;
-                cpu_set_reg8(reg, u);
-                cpu_set_flags(ctx, !u, false, false, reg_val & 1);
-                return;
-            }
-        }
-
-        fprintf(stderr, "Invalid CB instruction: %02X\n", ctx->fetched_data);
-        NO_IMPL
+    // Per-opcode handler from cpu_ops.cpp, operand and op resolved at compile time
+    cpu_cb_handler(ctx->fetched_data & 0xFF)(ctx);
 }
 
 // Rotating
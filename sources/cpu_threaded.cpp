@@ -0,0 +1,607 @@
+#include <./../headers/cpu_threaded.hpp>
+#include <./../headers/cpu.hpp>
+#include <./../headers/cpu_fetch.hpp>
+#include <./../headers/cpu_flags.hpp>
+#include <./../headers/cpu_idle.hpp>
+#include <./../headers/interrupts.hpp>
+#include <./../headers/stack.hpp>
+#include <./../headers/dbg.hpp>
+#include <./../headers/gameboy.hpp>
+
+// Threaded-code core: every opcode has its own label with the operands and
+// timing of that exact instruction, and every handler ends with its own copy
+// of the dispatch (computed goto), so the host predicts each jump separately.
+// Bus accesses and emu_cycles() calls happen in the same order as in
+// fetch_data() + cpu_proc.cpp, so both cores produce the same machine state.
+
+#if defined(__GNUC__)
+
+// Register pairs
+
+static inline u16 reg_bc() { return gb->cpu.regs.bc; }
+static inline u16 reg_de() { return gb->cpu.regs.de; }
+static inline u16 reg_hl() { return gb->cpu.regs.hl; }
+static inline u16 reg_af() { cpu_flags_sync(&gb->cpu); return gb->cpu.regs.af; }
+
+static inline void set_bc(u16 v) { gb->cpu.regs.bc = v; }
+static inline void set_de(u16 v) { gb->cpu.regs.de = v; }
+static inline void set_hl(u16 v) { gb->cpu.regs.hl = v; }
+
+// Flags (-1 leaves the flag untouched, same as cpu_set_flags)
+
+#define FLAG_Z BIT(cpu_flags(&gb->cpu), 7)
+#define FLAG_N BIT(cpu_flags(&gb->cpu), 6)
+#define FLAG_H BIT(cpu_flags(&gb->cpu), 5)
+#define FLAG_C cpu_flag_c(&gb->cpu)
+
+static inline void set_flags(int z, int n, int h, int c) {
+    cpu_flags_sync(&gb->cpu);
+
+    if (z != -1) BIT_SET(gb->cpu.regs.f, 7, z);
+    if (n != -1) BIT_SET(gb->cpu.regs.f, 6, n);
+    if (h != -1) BIT_SET(gb->cpu.regs.f, 5, h);
+    if (c != -1) BIT_SET(gb->cpu.regs.f, 4, c);
+}
+
+// Memory
+
+static inline u8 mem_read(u16 address) {
+    u8 value = bus_read(address);
+    emu_cycles(1);
+    return value;
+}
+
+static inline void mem_write(u16 address, u8 value) {
+    bus_write(address, value);
+    emu_cycles(1);
+}
+
+static inline u8 fetch_opcode() {
+    gb->cpu.decoded = cpu_cache_lookup(gb->cpu.regs.pc);
+
+    if (gb->cpu.decoded) {
+        gb->cpu.regs.pc++;
+        emu_cycles(gb->cpu.decoded->length);
+        return gb->cpu.decoded->opcode;
+    }
+
+    u8 opcode = bus_read(gb->cpu.regs.pc++);
+    emu_cycles(1);
+    return opcode;
+}
+
+// 8-bit arithmetic
+
+static inline u8 alu_inc(u8 v) {
+    u8 r = v + 1;
+    cpu_flags_lazy(&gb->cpu, LF_INC, 0, 0, FLAG_C, r);
+    return r;
+}
+
+static inline u8 alu_dec(u8 v) {
+    u8 r = v - 1;
+    cpu_flags_lazy(&gb->cpu, LF_DEC, 0, 0, FLAG_C, r);
+    return r;
+}
+
+static inline void alu_add(u8 v) {
+    u16 r = gb->cpu.regs.a + v;
+    cpu_flags_lazy(&gb->cpu, LF_ADD, gb->cpu.regs.a, v, 0, r);
+    gb->cpu.regs.a = r & 0xFF;
+}
+
+static inline void alu_adc(u8 v) {
+    u16 a = gb->cpu.regs.a;
+    u16 c = FLAG_C;
+
+    gb->cpu.regs.a = (a + v + c) & 0xFF;
+    cpu_flags_lazy(&gb->cpu, LF_ADC, a, v, c, a + v + c);
+}
+
+static inline void alu_sub(u8 v) {
+    cpu_flags_lazy(&gb->cpu, LF_SUB, gb->cpu.regs.a, v, 0, 0);
+    gb->cpu.regs.a -= v;
+}
+
+static inline void alu_sbc(u8 v) {
+    u8 a = gb->cpu.regs.a;
+    u8 c = FLAG_C;
+
+    cpu_flags_lazy(&gb->cpu, LF_SBC, a, v, c, 0);
+    gb->cpu.regs.a = a - (u8)(v + c);
+}
+
+static inline void alu_and(u8 v) {
+    gb->cpu.regs.a &= v;
+    cpu_flags_lazy(&gb->cpu, LF_AND, 0, 0, 0, gb->cpu.regs.a);
+}
+
+static inline void alu_xor(u8 v) {
+    gb->cpu.regs.a ^= v;
+    cpu_flags_lazy(&gb->cpu, LF_OR, 0, 0, 0, gb->cpu.regs.a);
+}
+
+static inline void alu_or(u8 v) {
+    gb->cpu.regs.a |= v;
+    cpu_flags_lazy(&gb->cpu, LF_OR, 0, 0, 0, gb->cpu.regs.a);
+}
+
+static inline void alu_cp(u8 v) {
+    cpu_flags_lazy(&gb->cpu, LF_SUB, gb->cpu.regs.a, v, 0, 0);
+}
+
+// 16-bit arithmetic
+
+static inline void alu_add_hl(u16 v) {
+    u16 hl = reg_hl();
+    emu_cycles(1);
+
+    set_flags(-1, 0, (hl & 0xFFF) + (v & 0xFFF) >= 0x1000, (u32)hl + (u32)v >= 0x10000);
+    set_hl(hl + v);
+}
+
+static inline u16 sp_offset(u8 v) {
+    u16 sp = gb->cpu.regs.sp;
+    set_flags(0, 0, (sp & 0xF) + (v & 0xF) >= 0x10, (sp & 0xFF) + (v & 0xFF) >= 0x100);
+    return sp + (int8_t)v;
+}
+
+// Accumulator rotates and flag ops
+
+static inline void op_rlca() {
+    u8 c = gb->cpu.regs.a >> 7;
+    gb->cpu.regs.a = (gb->cpu.regs.a << 1) | c;
+    set_flags(0, 0, 0, c);
+}
+
+static inline void op_rrca() {
+    u8 c = gb->cpu.regs.a & 1;
+    gb->cpu.regs.a = (gb->cpu.regs.a >> 1) | (c << 7);
+    set_flags(0, 0, 0, c);
+}
+
+static inline void op_rla() {
+    u8 c = gb->cpu.regs.a >> 7;
+    gb->cpu.regs.a = (gb->cpu.regs.a << 1) | FLAG_C;
+    set_flags(0, 0, 0, c);
+}
+
+static inline void op_rra() {
+    u8 c = gb->cpu.regs.a & 1;
+    gb->cpu.regs.a = (gb->cpu.regs.a >> 1) | (FLAG_C << 7);
+    set_flags(0, 0, 0, c);
+}
+
+static inline void op_daa() {
+    u8 u = 0;
+    int fc = 0;
+
+    if (FLAG_H || (!FLAG_N && (gb->cpu.regs.a & 0xF) > 9)) {
+        u = 6;
+    }
+
+    if (FLAG_C || (!FLAG_N && gb->cpu.regs.a > 0x99)) {
+        u |= 0x60;
+        fc = 1;
+    }
+
+    gb->cpu.regs.a += FLAG_N ? -u : u;
+    set_flags(gb->cpu.regs.a == 0, -1, 0, fc);
+}
+
+// Control flow
+
+static inline void jump(u16 address) {
+    gb->cpu.regs.pc = address;
+    emu_cycles(1);
+}
+
+// Taken JR/JP of `length` bytes, a backward one may close an idle loop
+static inline void branch(u16 address, u8 length) {
+    u16 from = gb->cpu.regs.pc - length;
+
+    jump(address);
+
+    if (address < from) {
+        cpu_idle_branch(from);
+    }
+}
+
+static inline void call(u16 address) {
+    emu_cycles(2);
+    stack_push16(gb->cpu.regs.pc);
+    jump(address);
+}
+
+static inline void ret() {
+    u16 lo = stack_pop();
+    emu_cycles(1);
+    u16 hi = stack_pop();
+    emu_cycles(1);
+
+    jump((hi << 8) | lo);
+}
+
+static inline u16 pop() {
+    u16 lo = stack_pop();
+    emu_cycles(1);
+    u16 hi = stack_pop();
+    emu_cycles(1);
+
+    return (hi << 8) | lo;
+}
+
+static inline void push(u16 v) {
+    emu_cycles(1);
+    stack_push(v >> 8);
+    emu_cycles(1);
+    stack_push(v & 0xFF);
+    emu_cycles(1);
+}
+
+// CB operations
+
+static inline u8 cb_rlc(u8 v) {
+    u8 r = (v << 1) | (v >> 7);
+    cpu_flags_lazy(&gb->cpu, LF_SHIFT, 0, 0, v >> 7, r);
+    return r;
+}
+
+static inline u8 cb_rrc(u8 v) {
+    u8 r = (v >> 1) | (v << 7);
+    cpu_flags_lazy(&gb->cpu, LF_SHIFT, 0, 0, v & 1, r);
+    return r;
+}
+
+static inline u8 cb_rl(u8 v) {
+    u8 r = (v << 1) | FLAG_C;
+    cpu_flags_lazy(&gb->cpu, LF_SHIFT, 0, 0, v >> 7, r);
+    return r;
+}
+
+static inline u8 cb_rr(u8 v) {
+    u8 r = (v >> 1) | (FLAG_C << 7);
+    cpu_flags_lazy(&gb->cpu, LF_SHIFT, 0, 0, v & 1, r);
+    return r;
+}
+
+static inline u8 cb_sla(u8 v) {
+    u8 r = v << 1;
+    cpu_flags_lazy(&gb->cpu, LF_SHIFT, 0, 0, v >> 7, r);
+    return r;
+}
+
+static inline u8 cb_sra(u8 v) {
+    u8 r = (int8_t)v >> 1;
+    cpu_flags_lazy(&gb->cpu, LF_SHIFT, 0, 0, v & 1, r);
+    return r;
+}
+
+static inline u8 cb_swap(u8 v) {
+    u8 r = (v >> 4) | (v << 4);
+    cpu_flags_lazy(&gb->cpu, LF_SHIFT, 0, 0, 0, r);
+    return r;
+}
+
+static inline u8 cb_srl(u8 v) {
+    u8 r = v >> 1;
+    cpu_flags_lazy(&gb->cpu, LF_SHIFT, 0, 0, v & 1, r);
+    return r;
+}
+
+// Handler building blocks. The interrupt/EI bookkeeping is the same as the
+// tail of cpu_step().
+
+#define DISPATCH()                                                  \
+    {                                                               \
+        if (gb->cpu.int_master_enabled) {                               \
+            if (gb->cpu.int_flags & gb->cpu.ie_register) {                  \
+                cpu_handle_interrupts(&gb->cpu);                        \
+            }                                                       \
+            gb->cpu.enabling_ime = false;                               \
+        }                                                           \
+        if (gb->cpu.enabling_ime) {                                     \
+            gb->cpu.int_master_enabled = true;                          \
+        }                                                           \
+        if (gb->cpu.halted || --steps == 0) {                           \
+            return true;                                            \
+        }                                                           \
+        op = fetch_opcode();                                        \
+        goto *ops[op];                                              \
+    }
+
+#define LD_R_R(label, dst, src)     label: { dbg_update(); gb->cpu.regs.dst = gb->cpu.regs.src; } DISPATCH();
+#define LD_R_HL(label, dst)         label: { u8 v = mem_read(reg_hl()); dbg_update(); gb->cpu.regs.dst = v; } DISPATCH();
+#define LD_HL_R(label, src)         label: { dbg_update(); mem_write(reg_hl(), gb->cpu.regs.src); } DISPATCH();
+#define LD_R_D8(label, dst)         label: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); gb->cpu.regs.dst = v; } DISPATCH();
+
+#define INC_R(label, r)             label: { dbg_update(); gb->cpu.regs.r = alu_inc(gb->cpu.regs.r); } DISPATCH();
+#define DEC_R(label, r)             label: { dbg_update(); gb->cpu.regs.r = alu_dec(gb->cpu.regs.r); } DISPATCH();
+
+#define ALU_R(label, src, fn)       label: { dbg_update(); fn(gb->cpu.regs.src); } DISPATCH();
+#define ALU_HL(label, fn)           label: { u8 v = mem_read(reg_hl()); dbg_update(); fn(v); } DISPATCH();
+#define ALU_D8(label, fn)           label: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); fn(v); } DISPATCH();
+
+#define JR_CC(label, cond)          label: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); if (cond) { branch(gb->cpu.regs.pc + (int8_t)v, 2); } } DISPATCH();
+#define JP_CC(label, cond)          label: { u16 v = fetch_imm16(&gb->cpu); dbg_update(); if (cond) { branch(v, 3); } } DISPATCH();
+#define CALL_CC(label, cond)        label: { u16 v = fetch_imm16(&gb->cpu); dbg_update(); if (cond) { call(v); } } DISPATCH();
+#define RET_CC(label, cond)         label: { dbg_update(); emu_cycles(1); if (cond) { ret(); } } DISPATCH();
+#define RST(label, address)         label: { dbg_update(); call(address); } DISPATCH();
+
+// A row of 8 opcodes on B, C, D, E, H, L, (HL), A; lo/hi picks the half of the hex row
+#define REG_ROW(row, l0, l1, l2, l3, l4, l5, l6, l7, R, HL, arg)           \
+    R(row##l0, arg, b) R(row##l1, arg, c) R(row##l2, arg, d) R(row##l3, arg, e) \
+    R(row##l4, arg, h) R(row##l5, arg, l) HL(row##l6, arg)   R(row##l7, arg, a)
+
+#define REG_ROW_LO(row, R, HL, arg) REG_ROW(row, 0, 1, 2, 3, 4, 5, 6, 7, R, HL, arg)
+#define REG_ROW_HI(row, R, HL, arg) REG_ROW(row, 8, 9, A, B, C, D, E, F, R, HL, arg)
+
+#define LD_ROW_R(label, dst, src)   LD_R_R(label, dst, src)
+#define LD_ROW_HL(label, dst)       LD_R_HL(label, dst)
+#define ALU_ROW_R(label, fn, src)   ALU_R(label, src, fn)
+#define ALU_ROW_HL(label, fn)       ALU_HL(label, fn)
+
+#define CB_R(label, fn, r)          label: { u8 v = gb->cpu.regs.r; emu_cycles(1); gb->cpu.regs.r = fn(v); } DISPATCH();
+#define CB_HL(label, fn)            label: { u16 hl = reg_hl(); u8 v = bus_read(hl); emu_cycles(3); bus_write(hl, fn(v)); } DISPATCH();
+#define BIT_R(label, n, r)          label: { u8 v = gb->cpu.regs.r; emu_cycles(1); cpu_flags_bit(&gb->cpu, v & (1 << n)); } DISPATCH();
+#define BIT_HL(label, n)            label: { u8 v = bus_read(reg_hl()); emu_cycles(3); cpu_flags_bit(&gb->cpu, v & (1 << n)); } DISPATCH();
+#define RES_R(label, n, r)          label: { u8 v = gb->cpu.regs.r; emu_cycles(1); gb->cpu.regs.r = v & ~(1 << n); } DISPATCH();
+#define RES_HL(label, n)            label: { u16 hl = reg_hl(); u8 v = bus_read(hl); emu_cycles(3); bus_write(hl, v & ~(1 << n)); } DISPATCH();
+#define SET_R(label, n, r)          label: { u8 v = gb->cpu.regs.r; emu_cycles(1); gb->cpu.regs.r = v | (1 << n); } DISPATCH();
+#define SET_HL(label, n)            label: { u16 hl = reg_hl(); u8 v = bus_read(hl); emu_cycles(3); bus_write(hl, v | (1 << n)); } DISPATCH();
+
+#define LABELS(p, row)                                                      \
+    &&p##row##0, &&p##row##1, &&p##row##2, &&p##row##3,                     \
+    &&p##row##4, &&p##row##5, &&p##row##6, &&p##row##7,                     \
+    &&p##row##8, &&p##row##9, &&p##row##A, &&p##row##B,                     \
+    &&p##row##C, &&p##row##D, &&p##row##E, &&p##row##F
+
+#define LABEL_TABLE(p)                                                      \
+    LABELS(p, 0), LABELS(p, 1), LABELS(p, 2), LABELS(p, 3),                 \
+    LABELS(p, 4), LABELS(p, 5), LABELS(p, 6), LABELS(p, 7),                 \
+    LABELS(p, 8), LABELS(p, 9), LABELS(p, A), LABELS(p, B),                 \
+    LABELS(p, C), LABELS(p, D), LABELS(p, E), LABELS(p, F)
+
+bool cpu_threaded_exec(u32 steps) {
+    static void *const ops[256] = { LABEL_TABLE(op_) };
+    static void *const cb_ops[256] = { LABEL_TABLE(cb_) };
+
+    if (gb->cpu.halted) {
+        // Halted cycles and wake-up go through the interpreter
+        return cpu_step();
+    }
+
+    u8 op = fetch_opcode();
+    goto *ops[op];
+
+    //0x0X
+    op_00: { dbg_update(); } DISPATCH();
+    op_01: { u16 v = fetch_imm16(&gb->cpu); dbg_update(); set_bc(v); } DISPATCH();
+    op_02: { dbg_update(); mem_write(reg_bc(), gb->cpu.regs.a); } DISPATCH();
+    op_03: { dbg_update(); emu_cycles(1); set_bc(reg_bc() + 1); } DISPATCH();
+    INC_R(op_04, b)
+    DEC_R(op_05, b)
+    LD_R_D8(op_06, b)
+    op_07: { dbg_update(); op_rlca(); } DISPATCH();
+    op_08: { u16 v = fetch_imm16(&gb->cpu); dbg_update(); emu_cycles(1); bus_write16(v, gb->cpu.regs.sp); emu_cycles(1); } DISPATCH();
+    op_09: { dbg_update(); alu_add_hl(reg_bc()); } DISPATCH();
+    op_0A: { u8 v = mem_read(reg_bc()); dbg_update(); gb->cpu.regs.a = v; } DISPATCH();
+    op_0B: { dbg_update(); emu_cycles(1); set_bc(reg_bc() - 1); } DISPATCH();
+    INC_R(op_0C, c)
+    DEC_R(op_0D, c)
+    LD_R_D8(op_0E, c)
+    op_0F: { dbg_update(); op_rrca(); } DISPATCH();
+
+    //0x1X
+    op_10: { dbg_update(); fprintf(stderr, "STOPPING\n\n"); } DISPATCH();
+    op_11: { u16 v = fetch_imm16(&gb->cpu); dbg_update(); set_de(v); } DISPATCH();
+    op_12: { dbg_update(); mem_write(reg_de(), gb->cpu.regs.a); } DISPATCH();
+    op_13: { dbg_update(); emu_cycles(1); set_de(reg_de() + 1); } DISPATCH();
+    INC_R(op_14, d)
+    DEC_R(op_15, d)
+    LD_R_D8(op_16, d)
+    op_17: { dbg_update(); op_rla(); } DISPATCH();
+    JR_CC(op_18, true)
+    op_19: { dbg_update(); alu_add_hl(reg_de()); } DISPATCH();
+    op_1A: { u8 v = mem_read(reg_de()); dbg_update(); gb->cpu.regs.a = v; } DISPATCH();
+    op_1B: { dbg_update(); emu_cycles(1); set_de(reg_de() - 1); } DISPATCH();
+    INC_R(op_1C, e)
+    DEC_R(op_1D, e)
+    LD_R_D8(op_1E, e)
+    op_1F: { dbg_update(); op_rra(); } DISPATCH();
+
+    //0x2X
+    JR_CC(op_20, !FLAG_Z)
+    op_21: { u16 v = fetch_imm16(&gb->cpu); dbg_update(); set_hl(v); } DISPATCH();
+    op_22: { u16 hl = reg_hl(); set_hl(hl + 1); dbg_update(); mem_write(hl, gb->cpu.regs.a); } DISPATCH();
+    op_23: { dbg_update(); emu_cycles(1); set_hl(reg_hl() + 1); } DISPATCH();
+    INC_R(op_24, h)
+    DEC_R(op_25, h)
+    LD_R_D8(op_26, h)
+    op_27: { dbg_update(); op_daa(); } DISPATCH();
+    JR_CC(op_28, FLAG_Z)
+    op_29: { dbg_update(); alu_add_hl(reg_hl()); } DISPATCH();
+    op_2A: { u16 hl = reg_hl(); u8 v = mem_read(hl); set_hl(hl + 1); dbg_update(); gb->cpu.regs.a = v; } DISPATCH();
+    op_2B: { dbg_update(); emu_cycles(1); set_hl(reg_hl() - 1); } DISPATCH();
+    INC_R(op_2C, l)
+    DEC_R(op_2D, l)
+    LD_R_D8(op_2E, l)
+    op_2F: { dbg_update(); gb->cpu.regs.a = ~gb->cpu.regs.a; set_flags(-1, 1, 1, -1); } DISPATCH();
+
+    //0x3X
+    JR_CC(op_30, !FLAG_C)
+    op_31: { u16 v = fetch_imm16(&gb->cpu); dbg_update(); gb->cpu.regs.sp = v; } DISPATCH();
+    op_32: { u16 hl = reg_hl(); set_hl(hl - 1); dbg_update(); mem_write(hl, gb->cpu.regs.a); } DISPATCH();
+    op_33: { dbg_update(); emu_cycles(1); gb->cpu.regs.sp++; } DISPATCH();
+    op_34: {
+        mem_read(reg_hl());
+        dbg_update();
+        emu_cycles(1);
+        u16 hl = reg_hl();
+        bus_write(hl, alu_inc(bus_read(hl)));
+    } DISPATCH();
+    op_35: {
+        mem_read(reg_hl());
+        dbg_update();
+        emu_cycles(1);
+        u16 hl = reg_hl();
+        bus_write(hl, alu_dec(bus_read(hl)));
+    } DISPATCH();
+    op_36: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); mem_write(reg_hl(), v); } DISPATCH();
+    op_37: { dbg_update(); set_flags(-1, 0, 0, 1); } DISPATCH();
+    JR_CC(op_38, FLAG_C)
+    op_39: { dbg_update(); alu_add_hl(gb->cpu.regs.sp); } DISPATCH();
+    op_3A: { u16 hl = reg_hl(); u8 v = mem_read(hl); set_hl(hl - 1); dbg_update(); gb->cpu.regs.a = v; } DISPATCH();
+    op_3B: { dbg_update(); emu_cycles(1); gb->cpu.regs.sp--; } DISPATCH();
+    INC_R(op_3C, a)
+    DEC_R(op_3D, a)
+    LD_R_D8(op_3E, a)
+    op_3F: { dbg_update(); set_flags(-1, 0, 0, FLAG_C ^ 1); } DISPATCH();
+
+    //0x4X - 0x7X
+    REG_ROW_LO(op_4, LD_ROW_R, LD_ROW_HL, b)
+    REG_ROW_HI(op_4, LD_ROW_R, LD_ROW_HL, c)
+    REG_ROW_LO(op_5, LD_ROW_R, LD_ROW_HL, d)
+    REG_ROW_HI(op_5, LD_ROW_R, LD_ROW_HL, e)
+    REG_ROW_LO(op_6, LD_ROW_R, LD_ROW_HL, h)
+    REG_ROW_HI(op_6, LD_ROW_R, LD_ROW_HL, l)
+    LD_HL_R(op_70, b)
+    LD_HL_R(op_71, c)
+    LD_HL_R(op_72, d)
+    LD_HL_R(op_73, e)
+    LD_HL_R(op_74, h)
+    LD_HL_R(op_75, l)
+    op_76: { dbg_update(); gb->cpu.halted = true; } DISPATCH();
+    LD_HL_R(op_77, a)
+    REG_ROW_HI(op_7, LD_ROW_R, LD_ROW_HL, a)
+
+    //0x8X - 0xBX
+    REG_ROW_LO(op_8, ALU_ROW_R, ALU_ROW_HL, alu_add)
+    REG_ROW_HI(op_8, ALU_ROW_R, ALU_ROW_HL, alu_adc)
+    REG_ROW_LO(op_9, ALU_ROW_R, ALU_ROW_HL, alu_sub)
+    REG_ROW_HI(op_9, ALU_ROW_R, ALU_ROW_HL, alu_sbc)
+    REG_ROW_LO(op_A, ALU_ROW_R, ALU_ROW_HL, alu_and)
+    REG_ROW_HI(op_A, ALU_ROW_R, ALU_ROW_HL, alu_xor)
+    REG_ROW_LO(op_B, ALU_ROW_R, ALU_ROW_HL, alu_or)
+    REG_ROW_HI(op_B, ALU_ROW_R, ALU_ROW_HL, alu_cp)
+
+    //0xCX
+    RET_CC(op_C0, !FLAG_Z)
+    op_C1: { dbg_update(); set_bc(pop()); } DISPATCH();
+    JP_CC(op_C2, !FLAG_Z)
+    JP_CC(op_C3, true)
+    CALL_CC(op_C4, !FLAG_Z)
+    op_C5: { dbg_update(); push(reg_bc()); } DISPATCH();
+    ALU_D8(op_C6, alu_add)
+    RST(op_C7, 0x00)
+    RET_CC(op_C8, FLAG_Z)
+    op_C9: { dbg_update(); ret(); } DISPATCH();
+    JP_CC(op_CA, FLAG_Z)
+    op_CB: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); goto *cb_ops[v]; }
+    CALL_CC(op_CC, FLAG_Z)
+    CALL_CC(op_CD, true)
+    ALU_D8(op_CE, alu_adc)
+    RST(op_CF, 0x08)
+
+    //0xDX
+    RET_CC(op_D0, !FLAG_C)
+    op_D1: { dbg_update(); set_de(pop()); } DISPATCH();
+    JP_CC(op_D2, !FLAG_C)
+    CALL_CC(op_D4, !FLAG_C)
+    op_D5: { dbg_update(); push(reg_de()); } DISPATCH();
+    ALU_D8(op_D6, alu_sub)
+    RST(op_D7, 0x10)
+    RET_CC(op_D8, FLAG_C)
+    op_D9: { dbg_update(); gb->cpu.int_master_enabled = true; ret(); } DISPATCH();
+    JP_CC(op_DA, FLAG_C)
+    CALL_CC(op_DC, FLAG_C)
+    ALU_D8(op_DE, alu_sbc)
+    RST(op_DF, 0x18)
+
+    //0xEX
+    op_E0: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); mem_write(0xFF00 | v, gb->cpu.regs.a); } DISPATCH();
+    op_E1: { dbg_update(); set_hl(pop()); } DISPATCH();
+    op_E2: { dbg_update(); mem_write(0xFF00 | gb->cpu.regs.c, gb->cpu.regs.a); } DISPATCH();
+    op_E5: { dbg_update(); push(reg_hl()); } DISPATCH();
+    ALU_D8(op_E6, alu_and)
+    RST(op_E7, 0x20)
+    op_E8: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); emu_cycles(1); gb->cpu.regs.sp = sp_offset(v); } DISPATCH();
+    op_E9: { dbg_update(); jump(reg_hl()); } DISPATCH();
+    op_EA: { u16 v = fetch_imm16(&gb->cpu); dbg_update(); mem_write(v, gb->cpu.regs.a); } DISPATCH();
+    ALU_D8(op_EE, alu_xor)
+    RST(op_EF, 0x28)
+
+    //0xFX
+    op_F0: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); gb->cpu.regs.a = mem_read(0xFF00 | v); } DISPATCH();
+    op_F1: { dbg_update(); u16 v = pop(); gb->cpu.regs.a = v >> 8; cpu_flags_set(&gb->cpu, v & 0xF0); } DISPATCH();
+    op_F2: { u8 v = mem_read(0xFF00 | gb->cpu.regs.c); dbg_update(); gb->cpu.regs.a = v; } DISPATCH();
+    op_F3: { dbg_update(); gb->cpu.int_master_enabled = false; } DISPATCH();
+    op_F5: { dbg_update(); push(reg_af()); } DISPATCH();
+    ALU_D8(op_F6, alu_or)
+    RST(op_F7, 0x30)
+    op_F8: { u8 v = fetch_imm8(&gb->cpu); dbg_update(); set_hl(sp_offset(v)); } DISPATCH();
+    op_F9: { dbg_update(); gb->cpu.regs.sp = reg_hl(); } DISPATCH();
+    op_FA: { u16 v = fetch_imm16(&gb->cpu); u8 n = mem_read(v); dbg_update(); gb->cpu.regs.a = n; } DISPATCH();
+    op_FB: { dbg_update(); gb->cpu.enabling_ime = true; } DISPATCH();
+    ALU_D8(op_FE, alu_cp)
+    RST(op_FF, 0x38)
+
+    // Unused opcodes (and the 0xFC quirk entry) take the generic path
+    op_D3: op_DB: op_DD: op_E3: op_E4: op_EB: op_EC: op_ED: op_F4: op_FC: op_FD: {
+        gb->cpu.current_opcode = op;
+        gb->cpu.current_inst = instruction_by_opcode(op);
+        cpu_op_handler(op)(&gb->cpu);
+    } DISPATCH();
+
+    // CB prefix
+    REG_ROW_LO(cb_0, CB_R, CB_HL, cb_rlc)
+    REG_ROW_HI(cb_0, CB_R, CB_HL, cb_rrc)
+    REG_ROW_LO(cb_1, CB_R, CB_HL, cb_rl)
+    REG_ROW_HI(cb_1, CB_R, CB_HL, cb_rr)
+    REG_ROW_LO(cb_2, CB_R, CB_HL, cb_sla)
+    REG_ROW_HI(cb_2, CB_R, CB_HL, cb_sra)
+    REG_ROW_LO(cb_3, CB_R, CB_HL, cb_swap)
+    REG_ROW_HI(cb_3, CB_R, CB_HL, cb_srl)
+
+    REG_ROW_LO(cb_4, BIT_R, BIT_HL, 0)
+    REG_ROW_HI(cb_4, BIT_R, BIT_HL, 1)
+    REG_ROW_LO(cb_5, BIT_R, BIT_HL, 2)
+    REG_ROW_HI(cb_5, BIT_R, BIT_HL, 3)
+    REG_ROW_LO(cb_6, BIT_R, BIT_HL, 4)
+    REG_ROW_HI(cb_6, BIT_R, BIT_HL, 5)
+    REG_ROW_LO(cb_7, BIT_R, BIT_HL, 6)
+    REG_ROW_HI(cb_7, BIT_R, BIT_HL, 7)
+
+    REG_ROW_LO(cb_8, RES_R, RES_HL, 0)
+    REG_ROW_HI(cb_8, RES_R, RES_HL, 1)
+    REG_ROW_LO(cb_9, RES_R, RES_HL, 2)
+    REG_ROW_HI(cb_9, RES_R, RES_HL, 3)
+    REG_ROW_LO(cb_A, RES_R, RES_HL, 4)
+    REG_ROW_HI(cb_A, RES_R, RES_HL, 5)
+    REG_ROW_LO(cb_B, RES_R, RES_HL, 6)
+    REG_ROW_HI(cb_B, RES_R, RES_HL, 7)
+
+    REG_ROW_LO(cb_C, SET_R, SET_HL, 0)
+    REG_ROW_HI(cb_C, SET_R, SET_HL, 1)
+    REG_ROW_LO(cb_D, SET_R, SET_HL, 2)
+    REG_ROW_HI(cb_D, SET_R, SET_HL, 3)
+    REG_ROW_LO(cb_E, SET_R, SET_HL, 4)
+    REG_ROW_HI(cb_E, SET_R, SET_HL, 5)
+    REG_ROW_LO(cb_F, SET_R, SET_HL, 6)
+    REG_ROW_HI(cb_F, SET_R, SET_HL, 7)
+}
+
+#else
+
+// Labels-as-values is a GNU extension, without it the interpreter is used
+bool cpu_threaded_exec(u32 steps) {
+    for (u32 i = 0; i < steps; i++) {
+        if (!cpu_step()) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+#endif
@@ -1,14 +1,15 @@
 #include <../headers/dbg.hpp> 
 #include <../headers/bus.hpp>
-
-static char dbg_msg[1024] = {0};
-static int msg_size = 0;
+#include <../headers/gameboy.hpp>
 
 void dbg_update() {
     if (bus_read(0xFF02) == 0x81) {
         char c = bus_read(0xFF01);
 
-        dbg_msg[msg_size++] = c;
+        // Keeps the last byte for the terminator
+        if (gb->dbg.size < (int)sizeof(gb->dbg.msg) - 1) {
+            gb->dbg.msg[gb->dbg.size++] = c;
+        }
 
         bus_write(0xFF02, 0);
     }
@@ -16,7 +17,15 @@ void dbg_update() {
 
 // Serial Debugging (NOT USED)
 void dbg_print() {
-    // if (dbg_msg[0]) {
-    //     printf("DBG: %s\n", dbg_msg);
+    // if (gb->dbg.msg[0]) {
+    //     printf("DBG: %s\n", gb->dbg.msg);
     // }
 }
+
+const char *dbg_get_serial() {
+    return gb->dbg.msg;
+}
+
+int dbg_get_serial_size() {
+    return gb->dbg.size;
+}
@@ -1,43 +1,48 @@
 #include <./../headers/ppu.hpp> 
 #include <./../headers/dma.hpp> 
 #include <./../headers/bus.hpp> 
+#include <./../headers/scheduler.hpp>
+#include <./../headers/gameboy.hpp>
 #include <unistd.h>
 
-typedef struct{
-    bool active;
-    u8 byte;
-    u8 value;
-    u8 start_delay;
-} dma_context;
-
-static dma_context ctx;
+// The source is read in one go when the transfer starts and lands in OAM
+// when it ends. In between the CPU is locked out of OAM for as long as the
+// byte-per-cycle copy took: 2 M-cycles of start delay plus 160 bytes.
+#define DMA_TICKS ((2 + DMA_BYTES) * 4)
 
 void dma_start(u8 start){
-    ctx.active = true;
-    ctx.byte = 0;
-    ctx.start_delay = 2;
-    ctx.value = start;
+    // PanDocs: "The written value specifies the transfer source address divided by $100"
+    for (int i = 0; i < DMA_BYTES; i++){
+        gb->dma.data[i] = bus_read((start * 0x100) + i);
+    }
+
+    gb->dma.active = true;
+    gb->dma.value = start;
+    gb->dma.end = sched_now() + DMA_TICKS;
 }
 
-void dma_tick(){
-    if (!ctx.active){
-        return;
+// Pandocs: "Destination: $FE00-$FE9F"
+static void dma_finish(){
+    for (int i = 0; i < DMA_BYTES; i++){
+        ppu_oam_write(i, gb->dma.data[i]);
     }
 
-    if (ctx.start_delay){
-        ctx.start_delay--;
-        return;
-    }
+    gb->dma.active = false;
+}
 
-    // PanDocs: "The written value specifies the transfer source address divided by $100"
-    ppu_oam_write(ctx.byte, bus_read((ctx.value * 0x100) + ctx.byte));
+bool dma_transferring(){
+    return gb->dma.active && sched_now() < gb->dma.end;
+}
 
-    // Pandocs: "Destination: $FE00-$FE9F"  ->  FE9F + 0x001 = FEA0
-    ctx.byte ++;
-    ctx.active = ctx.byte < 0xA0;
+void dma_schedule(){
+    // Also the end of transfer event
+    if (gb->dma.active && sched_now() >= gb->dma.end){
+        dma_finish();
+    }
 
+    if (gb->dma.active){
+        sched_post(SCHED_DMA, gb->dma.end - sched_now() - 1);
+    } else {
+        sched_cancel(SCHED_DMA);
+    }
 }
-
-bool dma_transferring(){
-    return ctx.active;
-}
\ No newline at end of file
@@ -0,0 +1,183 @@
+#include "../headers/main.hpp"
+#include "../headers/cpu.hpp"
+#include "../headers/ppu.hpp"
+#include "../headers/timer.hpp"
+#include "../headers/scheduler.hpp"
+#include "../headers/gameboy.hpp"
+#include <string.h>
+
+// Core timing shared by the SDL front end (main.cpp) and the headless runner
+
+emu_context *emu_get_context() {
+    return &gb->emu;
+}
+
+void emu_init() {
+    // Power-on state, the instance may have run another cart before.
+    // Components without an init of their own start from zero.
+    memset(&gb->dma, 0, sizeof(gb->dma));
+    memset(&gb->ram, 0, sizeof(gb->ram));
+    memset(&gb->io, 0, sizeof(gb->io));
+    memset(&gb->gamepad, 0, sizeof(gb->gamepad));
+    memset(&gb->dbg, 0, sizeof(gb->dbg));
+
+    timer_init();
+    cpu_init();
+    ppu_init();
+    sched_init();
+
+    gb->emu.ticks = 0;
+    gb->emu.pending = 0;
+    gb->emu.budget = 0;
+}
+
+void emu_set_frame_callback(emu_frame_callback callback, void *user) {
+    gb->emu.frame_callback = callback;
+    gb->emu.frame_user = user;
+}
+
+void emu_frame_done() {
+    if (gb->emu.frame_callback) {
+        gb->emu.frame_callback(gb->emu.frame_user);
+    }
+}
+
+void emu_cycles(int cpu_cycles) {
+    gb->emu.ticks += cpu_cycles * 4;
+    gb->emu.pending += cpu_cycles;
+
+    // The next timer/PPU event is inside the banked cycles, run up to it now
+    if (gb->emu.pending > gb->emu.budget) {
+        emu_sync();
+    }
+}
+
+// Cycles the timer and PPU can count through before the next event
+static u32 emu_event_budget() {
+    return sched_idle_ticks() / 4;
+}
+
+void emu_sync() {
+    // Taken up front, the PPU reads through the bus and lands back here
+    u32 pending = gb->emu.pending;
+    gb->emu.pending = 0;
+
+    while (pending) {
+        if (!gb->emu.budget) {
+            // An event falls in this cycle, tick it through. The timer
+            // and DMA follow the clock on their own.
+            for (int n = 0 ; n < 4 ; n++){
+                ppu_tick();
+            }
+
+            pending--;
+
+            sched_advance(4);
+            sched_dispatch();
+            gb->emu.budget = emu_event_budget();
+            continue;
+        }
+
+        // Straight to the next event
+        u32 cycles = pending < gb->emu.budget ? pending : gb->emu.budget;
+
+        ppu_skip(cycles * 4);
+        sched_advance(cycles * 4);
+
+        pending -= cycles;
+        gb->emu.budget -= cycles;
+    }
+}
+
+void emu_sync_invalidate() {
+    sched_post_all();
+    gb->emu.budget = emu_event_budget();
+}
+
+u32 emu_idle_cycles() {
+    emu_sync();
+
+    return gb->emu.budget;
+}
+
+void emu_skip_cycles(u32 cpu_cycles) {
+    // Within the budget, so this only banks them
+    emu_cycles(cpu_cycles);
+}
+
+void emu_command_post(emu_command cmd) {
+    pthread_mutex_lock(&gb->emu.control_lock);
+
+    switch (cmd) {
+        case EMU_CMD_RUN:
+            gb->emu.paused = false;
+            gb->emu.steps = 0;
+            gb->emu.frame_steps = 0;
+            gb->emu.frame_stepping = false;
+            break;
+        case EMU_CMD_PAUSE:
+            gb->emu.paused = true;
+            gb->emu.steps = 0;
+            gb->emu.frame_steps = 0;
+            gb->emu.frame_stepping = false;
+            break;
+        case EMU_CMD_STEP:
+            gb->emu.paused = true;
+            gb->emu.steps++;
+            break;
+        case EMU_CMD_STEP_FRAME:
+            gb->emu.paused = true;
+            gb->emu.frame_steps++;
+            break;
+        case EMU_CMD_QUIT:
+            gb->emu.quit = true;
+            break;
+    }
+
+    pthread_cond_signal(&gb->emu.control_cond);
+    pthread_mutex_unlock(&gb->emu.control_lock);
+}
+
+u32 emu_command_wait() {
+    u32 steps = 0;
+
+    pthread_mutex_lock(&gb->emu.control_lock);
+
+    while (!gb->emu.quit) {
+        if (!gb->emu.frame_stepping && gb->emu.frame_steps) {
+            gb->emu.frame_steps--;
+            gb->emu.frame_stepping = true;
+            gb->emu.frame_start = ppu_get_context()->current_frame;
+        }
+
+        // One instruction at a time: a batch can skip idle loops and HALTs
+        // across any number of lines. The frame counter moves on entering
+        // VBlank, cpu_exec() leaves the PPU synced.
+        if (gb->emu.frame_stepping) {
+            if (ppu_get_context()->current_frame == gb->emu.frame_start) {
+                steps = 1;
+                break;
+            }
+
+            gb->emu.frame_stepping = false;
+            continue;
+        }
+
+        if (!gb->emu.paused) {
+            steps = CPU_EXEC_BATCH;
+            break;
+        }
+
+        if (gb->emu.steps) {
+            gb->emu.steps--;
+            steps = 1;
+            break;
+        }
+
+        pthread_cond_wait(&gb->emu.control_cond, &gb->emu.control_lock);
+    }
+
+    pthread_mutex_unlock(&gb->emu.control_lock);
+
+    return steps;
+}
@@ -0,0 +1,34 @@
+#include <./../headers/gameboy.hpp>
+
+gameboy *gb_create() {
+    gameboy *instance = new gameboy();
+
+    instance->core = CORE_INTERP;
+    instance->idle_skip = true;
+    instance->scanline = true;
+
+    pthread_mutex_init(&instance->emu.control_lock, NULL);
+    pthread_cond_init(&instance->emu.control_cond, NULL);
+
+    return instance;
+}
+
+void gb_destroy(gameboy *instance) {
+    // The teardown functions work on the bound instance
+    gb = instance;
+
+    cart_unload();
+    ppu_free();
+    cpu_dynarec_free();
+
+    gb = nullptr;
+
+    pthread_cond_destroy(&instance->emu.control_cond);
+    pthread_mutex_destroy(&instance->emu.control_lock);
+
+    delete instance;
+}
+
+void gb_bind(gameboy *instance) {
+    gb = instance;
+}
@@ -1,4 +1,5 @@
 #include <../headers/gamepad.hpp>
+#include <../headers/gameboy.hpp>
 #include <string.h>
 
 /*
@@ -7,29 +8,21 @@
 P1		Select buttons	Select d-pad	Start / Down	Select / Up	    B / Left	A / Right
 */
 
-typedef struct {
-    bool button_selected;
-    bool dir_selected;
-    gamepad_state controller;
-} gamepad_context;
-
-static gamepad_context ctx = {0};
-
 bool gamepad_button_selected(){
-    return ctx.button_selected;
+    return gb->gamepad.button_selected;
 }
 
 bool gamepad_dir_selected(){
-    return ctx.dir_selected;
+    return gb->gamepad.dir_selected;
 }
 
 void gamepad_set_selected(u8 value){
-    ctx.button_selected = value & 0b100000;     // we select buttons with bit 5
-    ctx.dir_selected = value & 0b010000;        // we select directions with bit 4
+    gb->gamepad.button_selected = value & 0b100000;     // we select buttons with bit 5
+    gb->gamepad.dir_selected = value & 0b010000;        // we select directions with bit 4
 }
 
 gamepad_state * gamepad_get_state(){
-    return &ctx.controller;
+    return &gb->gamepad.controller;
 }
 
 u8 gamepad_get_output(){
@@ -5,8 +5,7 @@
 #include <../headers/lcd.hpp>
 #include <../headers/cpu.hpp>
 #include <../headers/gamepad.hpp>
-
-static char serial_data[2];
+#include <../headers/gameboy.hpp>
 
 u8 io_read(u16 address) {
 
@@ -15,11 +14,11 @@ u8 io_read(u16 address) {
     }
 
     if (address == 0xFF01) {
-        return serial_data[0];
+        return gb->io.serial_data[0];
     }
 
     if (address == 0xFF02) {
-        return serial_data[1];
+        return gb->io.serial_data[1];
     }
 
     if (BETWEEN(address, 0xFF04, 0xFF07)) {
@@ -58,12 +57,12 @@ void io_write(u16 address, u8 value) {
     }
 
     if (address == 0xFF01) {
-        serial_data[0] = value;
+        gb->io.serial_data[0] = value;
         return;
     }
 
     if (address == 0xFF02) {
-        serial_data[1] = value;
+        gb->io.serial_data[1] = value;
         return;
     }
 
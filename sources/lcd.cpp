@@ -1,46 +1,47 @@
 #include <../headers/lcd.hpp>
 #include <../headers/ppu.hpp>
 #include <../headers/dma.hpp>
+#include <../headers/gameboy.hpp>
+#include <string.h>
 
-static lcd_context ctx;
-
-static unsigned long colors_default[4] = {0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555, 0xFF000000}; 
+static const unsigned long colors_default[4] = {0xFFFFFFFF, 0xFFAAAAAA, 0xFF555555, 0xFF000000}; 
 
 void lcd_init(){
+    memset(&gb->lcd, 0, sizeof(gb->lcd));
 
-    ctx.lcdc            = 0x91;            // 10010001  
+    gb->lcd.lcdc            = 0x91;            // 10010001  
     
-    ctx.scroll_x        = 0;
-    ctx.scroll_y        = 0;
+    gb->lcd.scroll_x        = 0;
+    gb->lcd.scroll_y        = 0;
     
-    ctx.ly              = 0;
-    ctx.ly_compare      = 0;
+    gb->lcd.ly              = 0;
+    gb->lcd.ly_compare      = 0;
     
-    ctx.bg_palette      = 0xFC;
+    gb->lcd.bg_palette      = 0xFC;
     
-    ctx.obj_palette[0]  = 0xFF;
-    ctx.obj_palette[1]  = 0xFF;
+    gb->lcd.obj_palette[0]  = 0xFF;
+    gb->lcd.obj_palette[1]  = 0xFF;
 
-    ctx.win_y           = 0;
-    ctx.win_x           = 0;
+    gb->lcd.win_y           = 0;
+    gb->lcd.win_x           = 0;
 
     for (int i = 0 ; i < 4 ; i++){
-        ctx.bg_colors[i] = colors_default[i];
-        ctx.sp1_colors[i] = colors_default[i];
-        ctx.sp2_colors[i] = colors_default[i];
+        gb->lcd.bg_colors[i] = colors_default[i];
+        gb->lcd.sp1_colors[i] = colors_default[i];
+        gb->lcd.sp2_colors[i] = colors_default[i];
     }
 
 }
 
 lcd_context *lcd_get_context(){
-    return &ctx;    
+    return &gb->lcd;    
 }
 
 u8 lcd_read(u16 address){
     
     // Note how nice this is since the registers are in the order of the bus we can use the offset alone to read 
     u8 offset = (address - 0xFF40);
-    u8 *p = (u8 *)&ctx;
+    u8 *p = (u8 *)&gb->lcd;
 
     return p[offset];
 
@@ -48,14 +49,14 @@ u8 lcd_read(u16 address){
 
 
 void update_palette(u8 palette_data, u8 pal){
-    u32 *p_colors = ctx.bg_colors;
+    u32 *p_colors = gb->lcd.bg_colors;
 
     switch(pal){
         case 1:
-            p_colors = ctx.sp1_colors;
+            p_colors = gb->lcd.sp1_colors;
             break;
         case 2:
-            p_colors = ctx.sp2_colors;
+            p_colors = gb->lcd.sp2_colors;
             break;
     }
 
@@ -68,7 +69,19 @@ void update_palette(u8 palette_data, u8 pal){
 void lcd_write(u16 address, u8 value){
     
     u8 offset = (address - 0xFF40);
-    u8 *p = (u8 *)&ctx;
+    u8 *p = (u8 *)&gb->lcd;
+
+    // Everything but LYC and DMA can change what mode 3 draws
+    if (offset != 5 && offset != 6){
+        ppu_line_fallback();
+    }
+
+    if (offset == 1){               // FF41 STAT
+        // The mode and LYC=LY bits are the PPU's, only the interrupt
+        // selects are written
+        value = (value & ~0b111) | (gb->lcd.lcds & 0b111);
+    }
+
     p[offset] = value;
 
     if (offset == 6){               // FF46 DMA
@@ -1,12 +1,15 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "../headers/main.hpp"
+#include "../headers/gameboy.hpp"
 #include "../headers/cart.hpp"
 #include "../headers/cpu.hpp"
+#include "../headers/cpu_idle.hpp"
 #include "../headers/ui.hpp"
-#include "../headers/dma.hpp"
 #include "../headers/ppu.hpp"
-#include "../headers/timer.hpp"
+#include "../headers/scheduler.hpp"
+#include "../headers/pacing.hpp"
 
 
 #include <pthread.h>
@@ -30,32 +33,46 @@
 
 std::string g_rom_path;
 
-static emu_context ctx;
+void *cpu_run(void *p) {
 
-emu_context *emu_get_context() {
-    return &ctx;
-}
+    // Same instance as the UI thread
+    gb_bind((gameboy *)p);
 
-void *cpu_run(void *p) {
+    emu_init();
+
+    emu_context *ctx = emu_get_context();
 
-    timer_init();
-    cpu_init();
-    ppu_init();
+    ctx->running = true;
 
-    ctx.running = true;
-    ctx.paused = false;
-    ctx.ticks = 0;
+    pacing_init();
+    u32 frame = ppu_get_context()->current_frame;
 
-    while(ctx.running) {
-        if (ctx.paused) {
-            delay(10);
-            continue;
+    while(ctx->running) {
+        // Sleeps here while paused, the UI posts the commands
+        u32 steps = emu_command_wait();
+        if (!steps) {
+            break;
         }
 
-        if (!cpu_step()) {
+        if (!cpu_exec(steps)) {
             printf("CPU Stopped\n");
             return 0;
         }
+
+        if (frame != ppu_get_context()->current_frame) {
+            frame = ppu_get_context()->current_frame;
+
+            if (pacing_frame()) {
+                printf("FPS: %d\n", pacing_fps());
+
+                // This block runs every second thus we can check if we need to save the cart
+                if (cart_need_save()){cart_battery_save();}
+            }
+        }
+    }
+
+    if (cart_need_save()) {
+        cart_battery_save();
     }
 
     return 0;
@@ -71,50 +88,27 @@ int emu_run(std::string g_rom_path) {
 
     pthread_t t1;
 
-    if (pthread_create(&t1, NULL, cpu_run, NULL)) {
+    if (pthread_create(&t1, NULL, cpu_run, gb)) {
         fprintf(stderr, "FAILED TO START MAIN CPU THREAD!\n");
         return -1;
     }
 
 
-    u32 prev_frame = 0;
-
-
-    while(!ctx.die) {
-        usleep(1000);
-        ui_handle_events();
-
-        // Only when there's a frame change we change the UI
-        if (prev_frame != ppu_get_context()->current_frame){
-            ui_update();
-        }
-
+    // Blocks between events, the CPU thread wakes it up on every new frame
+    while(!emu_get_context()->die) {
+        ui_wait_events();
+    }
 
-        prev_frame = ppu_get_context()->current_frame;
+    // Let the CPU thread finish the batch (and a cart save) before exiting
+    emu_command_post(EMU_CMD_QUIT);
+    pthread_join(t1, NULL);
 
-    }
+    cpu_idle_print_stats();
+    sched_print_stats();
 
     return 0;
 }
 
-void emu_cycles(int cpu_cycles) {
-    
-    for (int i = 0; i < cpu_cycles ; i++){
-        
-        // Timer ticks 4 TIMES per CPU Cycle
-        for (int n = 0 ; n < 4 ; n++){
-            ctx.ticks++;
-            timer_tick();
-            ppu_tick();
-        }
-        
-        // DMA ticks ONCE per CPU Cycle
-        dma_tick();
-    }
-}
-
-
-
 std::string zenity_select_folder() {
     std::array<char, 512> buffer;
     std::string result;
@@ -153,7 +147,48 @@ std::string zenity_select_folder() {
 
 // Entry point of the program
 int main(int argc, char **argv) {
-    
+
+    gb_bind(gb_create());
+
+    // --core interp|threaded|dynarec selects the CPU core
+    // --no-idle-skip runs idle loops cycle by cycle (accuracy testing)
+    // --no-scanline draws every line with the pixel FIFO
+    // --speed <x> runs at x times 59.7275 fps (0.25 - 16), --uncapped as fast as it can
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--no-idle-skip")) {
+            cpu_idle_set_enabled(false);
+        } else if (!strcmp(argv[i], "--no-scanline")) {
+            ppu_line_set_enabled(false);
+        } else if (!strcmp(argv[i], "--uncapped")) {
+            pacing_set_uncapped(true);
+        } else if (!strcmp(argv[i], "--speed") && i + 1 < argc) {
+            pacing_set_speed(atof(argv[++i]));
+        } else if (!strcmp(argv[i], "--core") && i + 1 < argc) {
+            const char *name = argv[++i];
+
+            if (!strcmp(name, "threaded")) {
+                cpu_set_core(CORE_THREADED);
+            } else if (!strcmp(name, "dynarec")) {
+                cpu_set_core(CORE_DYNAREC);
+            } else if (!strcmp(name, "interp")) {
+                cpu_set_core(CORE_INTERP);
+            } else {
+                printf("Unknown core: %s (expected interp, threaded or dynarec)\n", name);
+                return 1;
+            }
+        }
+    }
+
+    static const char *core_names[] = {"interp", "threaded", "dynarec"};
+    printf("CPU core: %s\n", core_names[cpu_get_core()]);
+    printf("Idle loop skipping: %s\n", cpu_idle_enabled() ? "on" : "off");
+
+    if (pacing_uncapped()) {
+        printf("Speed: uncapped\n");
+    } else {
+        printf("Speed: %.2fx\n", pacing_get_speed());
+    }
+
     std::string rom_folder = zenity_select_folder();
     if (rom_folder.empty()) {
         printf("No ROM folder selected. Exiting.\n");
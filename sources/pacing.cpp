@@ -0,0 +1,118 @@
+#include <./../headers/pacing.hpp>
+#include <time.h>
+
+#define NS_PER_SEC      1000000000ULL
+
+// Closer than this to the deadline the thread spins instead of sleeping
+#define PACING_SPIN_NS  1500000ULL
+
+// Further behind than this (a pause, a slow host) the schedule restarts
+// from now instead of rushing frames to catch up
+#define PACING_MAX_LAG_FRAMES 4
+
+typedef struct {
+    double speed;
+    bool uncapped;
+
+    u64 frame_ns;               // Frame period at the current speed
+    u64 deadline;               // When the next frame is due
+
+    u64 second_start;
+    u32 frames;
+    u32 fps;
+} pacing_context;
+
+// Every field spelled out: --speed is applied before pacing_init() runs
+static pacing_context ctx = {1.0, false, 0, 0, 0, 0, 0};
+
+static void pacing_update_period() {
+    ctx.frame_ns = (u64)((double)PACING_TICKS_PER_FRAME * NS_PER_SEC / PACING_CLOCK_HZ / ctx.speed);
+}
+
+u64 pacing_now_ns() {
+    timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+
+    return (u64)t.tv_sec * NS_PER_SEC + t.tv_nsec;
+}
+
+void pacing_init() {
+    pacing_update_period();
+
+    ctx.deadline = pacing_now_ns() + ctx.frame_ns;
+    ctx.second_start = pacing_now_ns();
+    ctx.frames = 0;
+    ctx.fps = 0;
+}
+
+void pacing_set_speed(double speed) {
+    if (speed < PACING_SPEED_MIN) {
+        speed = PACING_SPEED_MIN;
+    } else if (speed > PACING_SPEED_MAX) {
+        speed = PACING_SPEED_MAX;
+    }
+
+    ctx.speed = speed;
+    pacing_update_period();
+}
+
+double pacing_get_speed() {
+    return ctx.speed;
+}
+
+void pacing_set_uncapped(bool uncapped) {
+    ctx.uncapped = uncapped;
+}
+
+bool pacing_uncapped() {
+    return ctx.uncapped;
+}
+
+u32 pacing_fps() {
+    return ctx.fps;
+}
+
+static void pacing_wait(u64 deadline) {
+    u64 now = pacing_now_ns();
+
+    if (deadline > now + PACING_SPIN_NS) {
+        u64 sleep = deadline - now - PACING_SPIN_NS;
+        timespec t = {(time_t)(sleep / NS_PER_SEC), (long)(sleep % NS_PER_SEC)};
+
+        nanosleep(&t, NULL);
+    }
+
+    while (pacing_now_ns() < deadline) {
+        // Spin the last stretch
+    }
+}
+
+bool pacing_frame() {
+    u64 now = pacing_now_ns();
+
+    if (!ctx.uncapped) {
+        if (now + ctx.frame_ns * PACING_MAX_LAG_FRAMES < ctx.deadline ||
+            now > ctx.deadline + ctx.frame_ns * PACING_MAX_LAG_FRAMES) {
+            // Speed changed or we fell too far behind
+            ctx.deadline = now;
+        } else if (now < ctx.deadline) {
+            pacing_wait(ctx.deadline);
+        }
+
+        // Off the previous deadline, not the wake-up time, so errors don't add up
+        ctx.deadline += ctx.frame_ns;
+        now = pacing_now_ns();
+    }
+
+    ctx.frames++;
+
+    if (now - ctx.second_start < NS_PER_SEC) {
+        return false;
+    }
+
+    ctx.fps = ctx.frames;
+    ctx.frames = 0;
+    ctx.second_start = now;
+
+    return true;
+}
@@ -2,44 +2,84 @@
 #include "../headers/ppu.hpp"
 #include "../headers/lcd.hpp"
 #include <../headers/ppu_sm.hpp>
+#include <../headers/scheduler.hpp>
+#include "../headers/gameboy.hpp"
+#include "../headers/main.hpp"
+#include "../headers/ppu_decode.hpp"
 #include <string.h>
 
 
-static ppu_context ctx;
-
 void pipeline_fifo_reset();
 void pipeline_process();
 
 ppu_context *ppu_get_context(){
-    return &ctx;
+    return &gb->ppu;
 }
 
 void ppu_init(){
-    ctx.current_frame = 0;
-    ctx.line_ticks = 0;
+    gb->ppu.current_frame = 0;
+    gb->ppu.line_ticks = 0;
     
-    ctx.video_buffer = new u32[YRES * XRES];
-    memset(ctx.video_buffer, 0, YRES * XRES * sizeof(u32));
+    for (int i = 0; i < PPU_FRAME_BUFFERS; i++){
+        if (!gb->ppu.frame_buffers[i]){
+            gb->ppu.frame_buffers[i] = new u32[YRES * XRES];
+        }
+
+        memset(gb->ppu.frame_buffers[i], 0, YRES * XRES * sizeof(u32));
+    }
 
-    ctx.pfc.line_x = 0;
-    ctx.pfc.pushed_x = 0;
-    ctx.pfc.pixel_fifo.size = 0;
-    ctx.pfc.pixel_fifo.head = ctx.pfc.pixel_fifo.tail = nullptr;
-    ctx.pfc.cur_fetch_state = FS_TILE;
+    gb->ppu.back = 0;
+    gb->ppu.ready = 1;
+    gb->ppu.front = 2;
+    gb->ppu.video_buffer = gb->ppu.frame_buffers[gb->ppu.back];
 
-    ctx.line_sprites = 0;
-    ctx.fetched_entry_count = 0;
-    ctx.window_line = 0;
+    memset(&gb->ppu.pfc, 0, sizeof(gb->ppu.pfc));
+    gb->ppu.pfc.cur_fetch_state = FS_TILE;
+
+    gb->ppu.line_sprite_count = 0;
+    gb->ppu.fetched_entry_count = 0;
+    gb->ppu.window_line = 0;
+
+    gb->ppu.line_fast = false;
+    memset(&gb->ppu.line_stats, 0, sizeof(gb->ppu.line_stats));
 
     lcd_init();
     LCDS_MODE_SET(MODE_OAM);
 
-    memset(ctx.oam_ram, 0, sizeof(ctx.oam_ram));
-    memset(ctx.video_buffer, 0, YRES * XRES * sizeof(u32));
+    memset(gb->ppu.oam_ram, 0, sizeof(gb->ppu.oam_ram));
+    oam_bins_reset();
+    memset(gb->ppu.vram, 0, sizeof(gb->ppu.vram));
+    memset(gb->ppu.tiles.dirty, true, sizeof(gb->ppu.tiles.dirty));
+}
+
+void ppu_frame_publish(){
+    // Release: the pixels are written before the UI can pick the slot up
+    u8 prev = gb->ppu.ready.exchange(gb->ppu.back | PPU_FRAME_FRESH, std::memory_order_acq_rel);
+
+    gb->ppu.back = prev & ~PPU_FRAME_FRESH;
+    gb->ppu.video_buffer = gb->ppu.frame_buffers[gb->ppu.back];
+
+    emu_frame_done();
+}
+
+const u32 *ppu_frame_acquire(){
+    if (gb->ppu.ready.load(std::memory_order_relaxed) & PPU_FRAME_FRESH){
+        u8 prev = gb->ppu.ready.exchange(gb->ppu.front, std::memory_order_acq_rel);
+        gb->ppu.front = prev & ~PPU_FRAME_FRESH;
+    }
+
+    return gb->ppu.frame_buffers[gb->ppu.front];
+}
+
+void ppu_free(){
+    for (int i = 0; i < PPU_FRAME_BUFFERS; i++){
+        delete[] gb->ppu.frame_buffers[i];
+        gb->ppu.frame_buffers[i] = nullptr;
+    }
 }
 
 void ppu_tick(){
-    ctx.line_ticks++;
+    gb->ppu.line_ticks++;
 
     switch(LCDS_MODE){
         case MODE_OAM:
@@ -56,6 +96,41 @@ void ppu_tick(){
             break;
     }
 }
+
+u32 ppu_idle_ticks(){
+    int next;
+
+    switch(LCDS_MODE){
+        case MODE_OAM:
+            // Sprites are loaded on tick 1, mode 3 starts on tick 80
+            next = gb->ppu.line_ticks ? 80 : 1;
+            break;
+        case MODE_VBLANK:
+        case MODE_HBLANK:
+            next = TICKS_PER_LINE;
+            break;
+        default:
+            // Pixel transfer runs the FIFO every tick, unless the line is
+            // drawn at once when it ends
+            if (!gb->ppu.line_fast){
+                return 0;
+            }
+
+            next = gb->ppu.line_end;
+            break;
+    }
+
+    int idle = next - (int)gb->ppu.line_ticks - 1;
+    return idle > 0 ? idle : 0;
+}
+
+void ppu_skip(u32 ticks){
+    gb->ppu.line_ticks += ticks;
+}
+
+void ppu_schedule(){
+    sched_post(SCHED_PPU, ppu_idle_ticks());
+}
  
 void ppu_oam_write(u16 address, u8 value){
     
@@ -64,8 +139,14 @@ void ppu_oam_write(u16 address, u8 value){
         address -=0xFE00;
     }
 
-    u8 *p = (u8 *) ctx.oam_ram;
+    u8 *p = (u8 *) gb->ppu.oam_ram;
+    u8 old = p[address];
     p[address] = value;
+
+    // Y and X decide which lines draw the sprite and in what order
+    if ((address & 3) < 2 && old != value){
+        oam_bins_moved(address / 4, (address & 3) ? p[address & ~3] : old);
+    }
 }
 
 u8 ppu_oam_read(u16 address){
@@ -75,18 +156,32 @@ u8 ppu_oam_read(u16 address){
         address -=0xFE00;
     }
 
-    u8 *p = (u8 *) ctx.oam_ram;
+    u8 *p = (u8 *) gb->ppu.oam_ram;
     return p[address];
 }
 
 void ppu_vram_write(u16 address, u8 value){
+    ppu_line_fallback();
 
     // Here we assume address is already offsetted
-    ctx.vram[address - 0x8000] = value;
+    gb->ppu.vram[address - 0x8000] = value;
+
+    if (address < 0x9800){
+        gb->ppu.tiles.dirty[(address - 0x8000) / 16] = true;
+    }
 }
 
 u8 ppu_vram_read(u16 address){
     
     // Here we assume address is already offsetted
-    return ctx.vram[address - 0x8000];
-}
\ No newline at end of file
+    return gb->ppu.vram[address - 0x8000];
+}
+
+void ppu_tile_decode(u16 tile){
+    ppu_tile_cache *c = &gb->ppu.tiles;
+
+    ppu_decode_rows(gb->ppu.vram + (tile * 16), 8, c->pixels[tile][0], c->flipped[tile][0]);
+
+    c->dirty[tile] = false;
+    gb->ppu.line_stats.tile_decodes++;
+}
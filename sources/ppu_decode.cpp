@@ -0,0 +1,148 @@
+#include "../headers/ppu_decode.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+static constexpr ppu_decode_tables decode_tables_build() {
+    ppu_decode_tables t = {};
+
+    for (int b = 0; b < 256; b++) {
+        for (int x = 0; x < 8; x++) {
+            t.spread[b][x] = (b >> (7 - x)) & 1;
+            t.reverse[b] |= ((b >> x) & 1) << (7 - x);
+        }
+    }
+
+    return t;
+}
+
+extern const ppu_decode_tables ppu_decode_lut = decode_tables_build();
+
+static void decode_scalar(const u8 *data, u32 rows, u8 *out, u8 *flipped) {
+    for (u32 r = 0; r < rows; r++) {
+        u8 lo = data[r * 2];
+        u8 hi = data[(r * 2) + 1];
+
+        ppu_decode_row(lo, hi, out + (r * 8));
+        ppu_decode_row(ppu_decode_lut.reverse[lo], ppu_decode_lut.reverse[hi], flipped + (r * 8));
+    }
+}
+
+#if defined(__x86_64__)
+
+// Per-pixel bit masks: normal rows test bit 7 first, flipped rows bit 0.
+// Each pixel byte is (plane & mask) == mask, kept as 1 for lo and 2 for hi.
+
+// Two rows per 16 bytes, SSE2 is always there on x86-64
+static void decode_sse2(const u8 *data, u32 rows, u8 *out, u8 *flipped) {
+    const __m128i mask = _mm_set_epi8(1, 2, 4, 8, 16, 32, 64, (char)128,
+                                      1, 2, 4, 8, 16, 32, 64, (char)128);
+    const __m128i mask_flip = _mm_set_epi8((char)128, 64, 32, 16, 8, 4, 2, 1,
+                                           (char)128, 64, 32, 16, 8, 4, 2, 1);
+    const __m128i one = _mm_set1_epi8(1);
+    const __m128i two = _mm_set1_epi8(2);
+    u32 r = 0;
+
+    for (; r + 2 <= rows; r += 2) {
+        int pair;
+        memcpy(&pair, data + (r * 2), 4);
+
+        // lo0 hi0 lo1 hi1 -> lo0 x8 lo1 x8 and hi0 x8 hi1 x8
+        __m128i v = _mm_cvtsi32_si128(pair);
+        v = _mm_unpacklo_epi8(v, v);
+        v = _mm_unpacklo_epi16(v, v);
+        __m128i lo = _mm_shuffle_epi32(v, _MM_SHUFFLE(2, 2, 0, 0));
+        __m128i hi = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 1, 1));
+
+        __m128i px = _mm_or_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(lo, mask), mask), one),
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(hi, mask), mask), two));
+        __m128i px_flip = _mm_or_si128(
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(lo, mask_flip), mask_flip), one),
+            _mm_and_si128(_mm_cmpeq_epi8(_mm_and_si128(hi, mask_flip), mask_flip), two));
+
+        _mm_storeu_si128((__m128i *)(out + (r * 8)), px);
+        _mm_storeu_si128((__m128i *)(flipped + (r * 8)), px_flip);
+    }
+
+    decode_scalar(data + (r * 2), rows - r, out + (r * 8), flipped + (r * 8));
+}
+
+// Four rows per 32 bytes: the 8 source bytes are in both halves, a byte
+// shuffle spreads rows 0 - 1 over the low half and rows 2 - 3 over the high
+__attribute__((target("avx2")))
+static void decode_avx2(const u8 *data, u32 rows, u8 *out, u8 *flipped) {
+    const __m256i sel_lo = _mm256_setr_epi8(
+        0, 0, 0, 0, 0, 0, 0, 0, 2, 2, 2, 2, 2, 2, 2, 2,
+        4, 4, 4, 4, 4, 4, 4, 4, 6, 6, 6, 6, 6, 6, 6, 6);
+    const __m256i sel_hi = _mm256_add_epi8(sel_lo, _mm256_set1_epi8(1));
+    const __m256i mask = _mm256_set1_epi64x(0x0102040810204080LL);
+    const __m256i mask_flip = _mm256_set1_epi64x((long long)0x8040201008040201ULL);
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi8(2);
+    u32 r = 0;
+
+    for (; r + 4 <= rows; r += 4) {
+        long long quad;
+        memcpy(&quad, data + (r * 2), 8);
+
+        __m256i v = _mm256_set1_epi64x(quad);
+        __m256i lo = _mm256_shuffle_epi8(v, sel_lo);
+        __m256i hi = _mm256_shuffle_epi8(v, sel_hi);
+
+        __m256i px = _mm256_or_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(lo, mask), mask), one),
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(hi, mask), mask), two));
+        __m256i px_flip = _mm256_or_si256(
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(lo, mask_flip), mask_flip), one),
+            _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_and_si256(hi, mask_flip), mask_flip), two));
+
+        _mm256_storeu_si256((__m256i *)(out + (r * 8)), px);
+        _mm256_storeu_si256((__m256i *)(flipped + (r * 8)), px_flip);
+    }
+
+    decode_sse2(data + (r * 2), rows - r, out + (r * 8), flipped + (r * 8));
+}
+
+#endif
+
+// Slowest first
+static const ppu_decode_impl decode_kernels[] = {
+    {decode_scalar, "scalar"},
+#if defined(__x86_64__)
+    {decode_sse2, "sse2"},
+    {decode_avx2, "avx2"},
+#endif
+};
+
+// How many of them the CPU runs
+static u32 decode_kernels_usable() {
+#if defined(__x86_64__)
+    // Runs from a static constructor, before the CPU model is set up
+    __builtin_cpu_init();
+
+    // AVX2 is the last one, dropped when the CPU doesn't have it
+    return __builtin_cpu_supports("avx2") ? 3 : 2;
+#else
+    return 1;
+#endif
+}
+
+static const u32 decode_kernel_count = decode_kernels_usable();
+
+// The fastest one the CPU runs
+static const ppu_decode_impl kernel = decode_kernels[decode_kernel_count - 1];
+
+void ppu_decode_rows(const u8 *data, u32 rows, u8 *out, u8 *flipped) {
+    kernel.fn(data, rows, out, flipped);
+}
+
+const char *ppu_decode_kernel() {
+    return kernel.name;
+}
+
+const ppu_decode_impl *ppu_decode_kernels(u32 *count) {
+    *count = decode_kernel_count;
+    return decode_kernels;
+}
@@ -0,0 +1,265 @@
+#include "../headers/ppu.hpp"
+#include "../headers/lcd.hpp"
+#include "../headers/main.hpp"
+#include "../headers/gameboy.hpp"
+#include "../headers/ppu_decode.hpp"
+#include <stdio.h>
+
+/*
+  Scanline renderer: instead of running the fetcher and the pixel FIFO
+  (ppu_pipeline.cpp) on every dot of mode 3, the whole line is drawn in one
+  pass on the dot the FIFO would have pushed its last pixel. The pixels and
+  the length of mode 3 come out the same as long as nothing the FIFO reads
+  changes during mode 3. A write to VRAM or to an LCD register in mode 3
+  replays the FIFO up to that dot first (ppu_line_fallback()), and the rest
+  of the line runs dot by dot.
+*/
+
+// ppu_mode_oam() switches to mode 3 on dot 80, the FIFO runs from the next
+#define LINE_TRANSFER_START 81
+
+typedef struct {
+    u16 end;            // line_ticks when the 160th pixel is pushed
+    u8 tiles;           // Tiles fetched by then
+} line_timing;
+
+// Only the SCX fine scroll changes how long the FIFO takes: same fetch and
+// push rules as pipeline_fetch() and pipeline_push_pixel(), without pixels
+static line_timing line_simulate(u8 fine_x) {
+    fetch_state state = FS_TILE;
+    u32 size = 0;
+    u8 line_x = 0;
+    u8 pushed_x = 0;
+    line_timing timing = {0, 0};
+
+    for (u16 t = LINE_TRANSFER_START; ; t++) {
+        if (!(t & 1)) {
+            switch (state) {
+                case FS_TILE:  timing.tiles++; state = FS_DATA0; break;
+                case FS_DATA0: state = FS_DATA1; break;
+                case FS_DATA1: state = FS_IDLE; break;
+                case FS_IDLE:  state = FS_PUSH; break;
+                case FS_PUSH:
+                    if (size <= 8) {
+                        size += 8;
+                        state = FS_TILE;
+                    }
+                    break;
+            }
+        }
+
+        if (size > 8) {
+            size--;
+
+            if (line_x >= fine_x) {
+                pushed_x++;
+            }
+
+            line_x++;
+        }
+
+        if (pushed_x >= XRES) {
+            timing.end = t;
+            return timing;
+        }
+    }
+}
+
+static const line_timing line_timings[8] = {
+    line_simulate(0), line_simulate(1), line_simulate(2), line_simulate(3),
+    line_simulate(4), line_simulate(5), line_simulate(6), line_simulate(7)
+};
+
+typedef struct {
+    int x;              // Screen x - 8 + SCX fine scroll, like the FIFO's sp_x
+    const u8 *pixels;   // Color indexes of its row, already x-flipped
+    bool bg_priority;
+    const u32 *colors;
+} line_sprite;
+
+// Row of a decoded tile, `tile` counted from 0x8000
+static inline const u8 *line_tile_row(u16 tile, u8 row, bool x_flip) {
+    ppu_tile_cache *c = &gb->ppu.tiles;
+
+    if (c->dirty[tile]) {
+        ppu_tile_decode(tile);
+    }
+
+    return x_flip ? c->flipped[tile][row] : c->pixels[tile][row];
+}
+
+void ppu_line_set_enabled(bool e) {
+    gb->scanline = e;
+}
+
+bool ppu_line_enabled() {
+    return gb->scanline;
+}
+
+void ppu_line_begin() {
+    // With the BG off the FIFO keeps the previous tile index around for
+    // sprite priority, those lines stay on the FIFO. So do lines whose FIFO
+    // still holds pixels from a mode 3 that ended before the line was done
+    gb->ppu.line_fast = gb->scanline && LCDC_BGW_ENABLE &&
+                        gb->ppu.pfc.pixel_fifo.size == 0;
+
+    if (gb->ppu.line_fast) {
+        gb->ppu.line_end = line_timings[gb->lcd.scroll_x % 8].end;
+    }
+}
+
+void ppu_line_fallback() {
+    ppu_context *ppu = &gb->ppu;
+
+    if (!ppu->line_fast) {
+        return;
+    }
+
+    ppu->line_fast = false;
+    ppu->line_stats.fallbacks++;
+
+    // Nothing changed yet, so the FIFO catches up to where it would be
+    u32 now = ppu->line_ticks;
+
+    for (u32 t = LINE_TRANSFER_START; t <= now; t++) {
+        ppu->line_ticks = t;
+        pipeline_process();
+    }
+
+    ppu->line_ticks = now;
+
+    // The PPU needs every dot again
+    emu_sync_invalidate();
+}
+
+void ppu_line_render() {
+    ppu_context *ppu = &gb->ppu;
+    lcd_context *lcd = &gb->lcd;
+
+    u8 ly = lcd->ly;
+    u8 scroll_x = lcd->scroll_x;
+    u8 fine_x = scroll_x % 8;
+    u8 map_y = ly + lcd->scroll_y;
+    u8 tile_row = map_y % 8;
+
+    const u8 *vram = ppu->vram;
+    const u8 *bg_row = vram + (LCDC_BG_MAP_AREA - 0x8000) + (map_y / 8) * 32;
+    const u8 *win_row = vram + (LCDC_WIN_MAP_AREA - 0x8000) + (ppu->window_line / 8) * 32;
+    bool signed_tiles = LCDC_BGW_DATA_AREA == 0x8800;
+
+    // Cache tile of index 0: the 0x8800 area starts at tile 128
+    u16 tile_base = signed_tiles ? 128 : 0;
+
+    bool window = window_visible() && ly >= lcd->win_y && ly < lcd->win_y + XRES;
+    int win_x = lcd->win_x;
+
+    // Tile index of the k-th fetch, the window tile replaces the BG one
+    // (and uses the BG's row within the tile, as in the FIFO)
+    auto tile_index = [&](int k) -> u8 {
+        int fetch_x = k * 8;
+        u8 tile = bg_row[(u8)(fetch_x + scroll_x) / 8];
+
+        if (window && fetch_x + 7 >= win_x && fetch_x + 7 < win_x + YRES + 14) {
+            tile = win_row[(fetch_x + 7 - win_x) / 8];
+        }
+
+        return signed_tiles ? tile + 128 : tile;
+    };
+
+    line_sprite sprites[10];
+    int sprite_count = 0;
+
+    if (LCDC_OBJ_ENABLE) {
+        u8 sprite_height = LCDC_OBJ_HEIGHT;
+
+        for (int n = 0; n < ppu->line_sprite_count; n++) {
+            const oam_entry *e = &ppu->line_sprites[n];
+            line_sprite *s = &sprites[sprite_count++];
+            u8 ty = ((ly + 16) - e->y) * 2;
+            u8 tile = e->tile;
+
+            if (e->f_y_flip) {
+                ty = ((sprite_height * 2) - 2) - ty;
+            }
+
+            if (sprite_height == 16) {
+                tile &= ~(1);
+            }
+
+            // Lower half of an 8x16 sprite is the next tile
+            s->x = (e->x - 8) + fine_x;
+            s->pixels = line_tile_row(tile + (ty / 16), (ty % 16) / 2, e->f_x_flip);
+            s->bg_priority = e->f_bgp;
+            s->colors = e->f_pn ? lcd->sp2_colors : lcd->sp1_colors;
+        }
+    }
+
+    u32 *out = ppu->video_buffer + (ly * XRES);
+    int last_tile = (fine_x + XRES - 1) / 8;
+
+    // FIFO pixel p is screen pixel p - fine_x, fetched by tile p / 8
+    for (int k = 0; k <= last_tile; k++) {
+        const u8 *bg_pixels = line_tile_row(tile_base + tile_index(k), tile_row, false);
+
+        // Up to 3 sprites overlapping this fetch, in line_sprites order
+        line_sprite *fetched[3];
+        int fetched_count = 0;
+
+        for (int i = 0; i < sprite_count && fetched_count < 3; i++) {
+            int sp_x = sprites[i].x;
+
+            if ((sp_x >= k * 8 && sp_x < k * 8 + 8) ||
+                    (sp_x + 8 >= k * 8 && sp_x + 8 < k * 8 + 8)) {
+                fetched[fetched_count++] = &sprites[i];
+            }
+        }
+
+        int first = k ? 0 : fine_x;
+        int end = k < last_tile ? 8 : ((fine_x + XRES - 1) % 8) + 1;
+
+        for (int i = first; i < end; i++) {
+            int p = (k * 8) + i;
+            u8 bg_color = bg_pixels[i];
+            u32 color = lcd->bg_colors[bg_color];
+
+            for (int j = 0; j < fetched_count; j++) {
+                line_sprite *s = fetched[j];
+                int offset = p - s->x;
+
+                if (offset < 0 || offset > 7) {
+                    continue;
+                }
+
+                u8 sp_color = s->pixels[offset];
+
+                if (!sp_color) {
+                    // transparent
+                    continue;
+                }
+
+                if (!s->bg_priority || bg_color == 0) {
+                    color = s->colors[sp_color];
+                    break;
+                }
+            }
+
+            out[p - fine_x] = color;
+        }
+    }
+
+    // What the FIFO leaves in its fetcher, a later line with the BG off
+    // still reads the tile index
+    ppu->pfc.bgw_fetch_data[0] = tile_index(line_timings[fine_x].tiles - 1);
+}
+
+const ppu_line_stats *ppu_line_get_stats() {
+    return &gb->ppu.line_stats;
+}
+
+void ppu_line_print_stats() {
+    const ppu_line_stats *s = &gb->ppu.line_stats;
+
+    printf("Renderer: %llu lines scanline, %llu FIFO (%llu fell back in mode 3), %llu tiles decoded (%s)\n",
+        (unsigned long long)s->scanline, (unsigned long long)s->fifo,
+        (unsigned long long)s->fallbacks, (unsigned long long)s->tile_decodes, ppu_decode_kernel());
+}
@@ -0,0 +1,127 @@
+#include "../headers/ppu.hpp"
+#include "../headers/lcd.hpp"
+#include "../headers/gameboy.hpp"
+#include <string.h>
+
+/*
+  Sprite bins: for every visible line, a mask of the OAM entries whose Y
+  covers it and the (up to 10) entries it draws, sorted by X. An OAM write
+  that moves an entry only updates the lines it leaves and enters, and a
+  line re-sorts its bin on first use after that. A change of sprite height
+  (LCDC.2) rebuilds every mask.
+*/
+
+// Visible lines `y` covers at `height`, false when none
+static bool bins_lines(u8 y, u8 height, int *first, int *last) {
+    *first = y - 16;
+    *last = y - 16 + height - 1;
+
+    if (*first < 0) {
+        *first = 0;
+    }
+
+    if (*last >= YRES) {
+        *last = YRES - 1;
+    }
+
+    return *first <= *last;
+}
+
+static void bins_set(u8 index, u8 y, bool covers) {
+    oam_bins *bins = &gb->ppu.bins;
+    int first, last;
+
+    if (!bins_lines(y, bins->height, &first, &last)) {
+        return;
+    }
+
+    for (int line = first; line <= last; line++) {
+        if (covers) {
+            bins->masks[line] |= 1ULL << index;
+        } else {
+            bins->masks[line] &= ~(1ULL << index);
+        }
+
+        bins->dirty[line] = true;
+    }
+}
+
+static void bins_rebuild(u8 height) {
+    oam_bins *bins = &gb->ppu.bins;
+
+    memset(bins->masks, 0, sizeof(bins->masks));
+    memset(bins->dirty, true, sizeof(bins->dirty));
+    bins->height = height;
+
+    for (int i = 0; i < OAM_ENTRIES; i++) {
+        bins_set(i, gb->ppu.oam_ram[i].y, true);
+    }
+}
+
+// First 10 entries in OAM order that are on the line, sorted by X
+static void bins_sort(int line) {
+    oam_bins *bins = &gb->ppu.bins;
+    const oam_entry *oam = gb->ppu.oam_ram;
+    u8 *sprites = bins->sprites[line];
+    u64 mask = bins->masks[line];
+    u8 count = 0;
+
+    while (mask && count < LINE_SPRITES_MAX) {
+        int i = __builtin_ctzll(mask);
+        mask &= mask - 1;
+
+        if (oam[i].x == 0) {
+            // X = 0 is always invisible
+            continue;
+        }
+
+        // Equal X keeps OAM order
+        int n = count++;
+
+        while (n && oam[sprites[n - 1]].x > oam[i].x) {
+            sprites[n] = sprites[n - 1];
+            n--;
+        }
+
+        sprites[n] = i;
+    }
+
+    bins->counts[line] = count;
+    bins->dirty[line] = false;
+}
+
+void oam_bins_reset() {
+    gb->ppu.bins.height = 0;
+}
+
+void oam_bins_moved(u8 index, u8 old_y) {
+    oam_bins *bins = &gb->ppu.bins;
+    u8 y = gb->ppu.oam_ram[index].y;
+
+    if (!bins->height) {
+        return;
+    }
+
+    if (y != old_y) {
+        bins_set(index, old_y, false);
+    }
+
+    // Also re-sorts the lines when only X changed
+    bins_set(index, y, true);
+}
+
+const u8 *oam_bins_line(u8 line, u8 *count) {
+    oam_bins *bins = &gb->ppu.bins;
+    u8 height = LCDC_OBJ_HEIGHT;
+
+    if (bins->height != height) {
+        bins_rebuild(height);
+    }
+
+    if (bins->dirty[line]) {
+        bins_sort(line);
+    }
+
+    *count = bins->counts[line];
+    return bins->sprites[line];
+}
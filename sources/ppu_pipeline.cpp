@@ -1,6 +1,7 @@
 #include "../headers/ppu.hpp"
 #include "../headers/lcd.hpp"
 #include "../headers/bus.hpp"
+#include "../headers/ppu_decode.hpp"
 
 bool window_visible() {
     return LCDC_WIN_ENABLE && lcd_get_context()->win_x >= 0 &&
@@ -9,39 +10,29 @@ bool window_visible() {
 }
 
 void pixel_fifo_push(u32 value) {
-    fifo_entry *next = new fifo_entry;
-    next->next = NULL;
-    next->value = value;
+    fifo *f = &ppu_get_context()->pfc.pixel_fifo;
 
-    if (!ppu_get_context()->pfc.pixel_fifo.head) {
-
-        // first entry of the fifo...
-        ppu_get_context()->pfc.pixel_fifo.head = ppu_get_context()->pfc.pixel_fifo.tail = next;
-    } else {
-        ppu_get_context()->pfc.pixel_fifo.tail->next = next;
-        ppu_get_context()->pfc.pixel_fifo.tail = next;
-    }
-
-    ppu_get_context()->pfc.pixel_fifo.size++;
+    f->entries[f->tail] = value;
+    f->tail = (f->tail + 1) & PIXEL_FIFO_MASK;
+    f->size++;
 }
 
 u32 pixel_fifo_pop() {
-    if (ppu_get_context()->pfc.pixel_fifo.size <= 0) {
+    fifo *f = &ppu_get_context()->pfc.pixel_fifo;
+
+    if (f->size <= 0) {
         fprintf(stderr, "ERR IN PIXEL FIFO!\n");
         exit(-8);
     }
 
-    fifo_entry *popped = ppu_get_context()->pfc.pixel_fifo.head;
-    ppu_get_context()->pfc.pixel_fifo.head = popped->next;
-    ppu_get_context()->pfc.pixel_fifo.size--;
-
-    u32 val = popped->value;
-    delete popped;
+    u32 val = f->entries[f->head];
+    f->head = (f->head + 1) & PIXEL_FIFO_MASK;
+    f->size--;
 
     return val;
 }
 
-u32 fetch_sprite_pixels(int bit, u32 color, u8 bg_color) {
+u32 fetch_sprite_pixels(u32 color, u8 bg_color) {
     for (int i=0; i<ppu_get_context()->fetched_entry_count; i++) {
         int sp_x = (ppu_get_context()->fetched_entries[i].x - 8) + 
             ((lcd_get_context()->scroll_x % 8));
@@ -58,29 +49,24 @@ u32 fetch_sprite_pixels(int bit, u32 color, u8 bg_color) {
             continue;
         }
 
-        bit = (7 - offset);
-
         if (ppu_get_context()->fetched_entries[i].f_x_flip) {
-            bit = offset;
+            offset = 7 - offset;
         }
 
-        u8 hi = !!(ppu_get_context()->pfc.fetch_entry_data[i * 2] & (1 << bit));
-        u8 lo = !!(ppu_get_context()->pfc.fetch_entry_data[(i * 2) + 1] & (1 << bit)) << 1;
+        u8 sp_color = ppu_get_context()->pfc.fetch_entry_pixels[i][offset];
 
         bool bg_priority = ppu_get_context()->fetched_entries[i].f_bgp;
 
-        if (!(hi|lo)) {
+        if (!sp_color) {
             // transparent
             continue;
         }
 
         if (!bg_priority || bg_color == 0) {
             color = (ppu_get_context()->fetched_entries[i].f_pn) ? 
-                lcd_get_context()->sp2_colors[hi|lo] : lcd_get_context()->sp1_colors[hi|lo];
+                lcd_get_context()->sp2_colors[sp_color] : lcd_get_context()->sp1_colors[sp_color];
 
-            if (hi|lo) {
-                break;
-            }
+            break;
         }
     }
 
@@ -95,18 +81,18 @@ bool pipeline_fifo_add() {
 
     int x = ppu_get_context()->pfc.fetch_x - (8 - (lcd_get_context()->scroll_x % 8));
 
+    u8 pixels[8];
+    ppu_decode_row(ppu_get_context()->pfc.bgw_fetch_data[1], ppu_get_context()->pfc.bgw_fetch_data[2], pixels);
+
     for (int i=0; i<8; i++) {
-        int bit = 7 - i;
-        u8 hi = !!(ppu_get_context()->pfc.bgw_fetch_data[1] & (1 << bit));
-        u8 lo = !!(ppu_get_context()->pfc.bgw_fetch_data[2] & (1 << bit)) << 1;
-        u32 color = lcd_get_context()->bg_colors[hi | lo];
+        u32 color = lcd_get_context()->bg_colors[pixels[i]];
 
         if (!LCDC_BGW_ENABLE) {
             color = lcd_get_context()->bg_colors[0];
         }
 
         if (LCDC_OBJ_ENABLE) {
-            color = fetch_sprite_pixels(bit, color, hi | lo);
+            color = fetch_sprite_pixels(color, pixels[i]);
         }
 
         if (x >= 0) {
@@ -119,19 +105,16 @@ bool pipeline_fifo_add() {
 }
 
 void pipeline_load_sprite_tile() {
-    oam_line_entry *le = ppu_get_context()->line_sprites;
-
-    while(le) {
-        int sp_x = (le->entry.x - 8) + (lcd_get_context()->scroll_x % 8);
+    for (int i=0; i<ppu_get_context()->line_sprite_count; i++) {
+        oam_entry *e = &ppu_get_context()->line_sprites[i];
+        int sp_x = (e->x - 8) + (lcd_get_context()->scroll_x % 8);
 
         if ((sp_x >= ppu_get_context()->pfc.fetch_x && sp_x < ppu_get_context()->pfc.fetch_x + 8) ||
             ((sp_x + 8) >= ppu_get_context()->pfc.fetch_x && (sp_x + 8) < ppu_get_context()->pfc.fetch_x + 8)) {
-            ppu_get_context()->fetched_entries[ppu_get_context()->fetched_entry_count++] = le->entry;
+            ppu_get_context()->fetched_entries[ppu_get_context()->fetched_entry_count++] = *e;
         }
 
-        le = le->next;
-
-        if (!le || ppu_get_context()->fetched_entry_count >= 3) {
+        if (ppu_get_context()->fetched_entry_count >= 3) {
             // We can only fetch 3 sprites per line
             break;
         }
@@ -159,6 +142,13 @@ void pipeline_load_sprite_data(u8 offset) {
 
         ppu_get_context()->pfc.fetch_entry_data[(i * 2) + offset] = 
             bus_read(0x8000 + (tile_index * 16) + ty + offset);
+
+        if (offset) {
+            // Both planes are in, once per fetch instead of per pixel
+            ppu_decode_row(ppu_get_context()->pfc.fetch_entry_data[i * 2],
+                ppu_get_context()->pfc.fetch_entry_data[(i * 2) + 1],
+                ppu_get_context()->pfc.fetch_entry_pixels[i]);
+        }
     }
 }
 
@@ -202,7 +192,7 @@ void pipeline_fetch() {
                 pipeline_load_window_tile();
             }
 
-            if (LCDC_OBJ_ENABLE && ppu_get_context()->line_sprites) {
+            if (LCDC_OBJ_ENABLE && ppu_get_context()->line_sprite_count) {
                 pipeline_load_sprite_tile();
             }
 
@@ -273,9 +263,9 @@ void pipeline_process() {
 }
 
 void pipeline_fifo_reset() {
-    while(ppu_get_context()->pfc.pixel_fifo.size) {
-        pixel_fifo_pop();
-    }
+    fifo *f = &ppu_get_context()->pfc.pixel_fifo;
 
-    ppu_get_context()->pfc.pixel_fifo.head = 0;
+    f->head = 0;
+    f->tail = 0;
+    f->size = 0;
 }
\ No newline at end of file
@@ -2,14 +2,8 @@
 #include "../headers/lcd.hpp"
 #include <../headers/cpu.hpp>
 #include <../headers/interrupts.hpp>
-#include <../headers/cart.hpp>
 #include <string.h>
 
-static u32 target_frame_time = 1000 / 60;
-static long prev_frame_time = 0;
-static long start_timer = 0;
-static long frame_count = 0;
-
 void increment_ly(){
 
     auto lcdgc = lcd_get_context();
@@ -34,61 +28,14 @@ void increment_ly(){
 }
 
 void load_line_sprites (){
-    int cur_y = lcd_get_context()->ly;
-
-    u8 sprite_height = LCDC_OBJ_HEIGHT;
-    memset(ppu_get_context()->line_entry_array, 0, 
-          sizeof(ppu_get_context()->line_entry_array));
-    
-    for (int i = 0 ; i < 40 ; i++){
-        oam_entry e = ppu_get_context()->oam_ram[i];
-        
-        if (e.x == 0){
-            // X = 0 is always invisible
-            continue;
-        }
-
-        if (ppu_get_context()->line_sprite_count >= 10){
-            // Only up to 10 sprites 
-            break;
-        }
-
-        if (e.y <= cur_y + 16 && e.y + sprite_height > cur_y + 16){
-            // The sprite is on the current line
-            oam_line_entry *entry = &ppu_get_context()->line_entry_array[ppu_get_context()->line_sprite_count++];
+    u8 count;
+    const u8 *bin = oam_bins_line(lcd_get_context()->ly, &count);
 
-            entry-> entry = e;
-            entry-> next = nullptr;
-
-            if(!ppu_get_context()->line_sprites || ppu_get_context()->line_sprites->entry.x > e.x){
-                entry-> next = ppu_get_context()->line_sprites;
-                ppu_get_context()->line_sprites = entry;
-                continue;
-            }
-
-            // Sort the sprites (Some games cannot render if sprites do not show up on the right order)
-            
-            oam_line_entry *le = ppu_get_context()->line_sprites;
-            oam_line_entry *prev = le;
-
-            while (le){
-                if (le->entry.x > e.x){
-                    prev->next = entry;
-                    entry->next = le;
-                    break;
-                }
-
-                if (!le->next){
-                    le->next = entry;
-                    break;
-                }
-
-                prev = le;
-                le = le -> next;
-            }
-        }
+    for (int i = 0 ; i < count ; i++){
+        ppu_get_context()->line_sprites[i] = ppu_get_context()->oam_ram[bin[i]];
     }
 
+    ppu_get_context()->line_sprite_count = count;
 }
 
 void ppu_mode_oam(){
@@ -100,23 +47,37 @@ void ppu_mode_oam(){
         ppu_get_context()->pfc.fetch_x          = 0;
         ppu_get_context()->pfc.pushed_x         = 0;
         ppu_get_context()->pfc.fifo_x           = 0;
+
+        ppu_line_begin();
     }
 
     if(ppu_get_context()->line_ticks == 1){
         // Read the OAM on the first tick only
-        ppu_get_context()-> line_sprites = 0;
-        ppu_get_context()-> line_sprite_count = 0;
-
         load_line_sprites();
     }
 }
 
 void ppu_mode_transfer(){
 
-    pipeline_process();
+    if (ppu_get_context()->line_fast){
+        if (ppu_get_context()->line_ticks < ppu_get_context()->line_end){
+            return;
+        }
+
+        ppu_line_render();
+        ppu_get_context()->pfc.pushed_x = XRES;
+        ppu_get_context()->line_stats.scanline++;
+    } else {
+        pipeline_process();
+
+        if (ppu_get_context()->pfc.pushed_x >= XRES){
+            ppu_get_context()->line_stats.fifo++;
+        }
+    }
 
     if (ppu_get_context()->pfc.pushed_x >= XRES){
         
+        ppu_get_context()->line_fast = false;
         pipeline_fifo_reset();
         LCDS_MODE_SET(MODE_HBLANK);
 
@@ -139,29 +100,9 @@ void ppu_mode_hblank(){
                 cpu_request_interrupt(IT_LCD_STAT);
             }
 
+            // Frame complete, pacing is up to the emulation loop (pacing.cpp)
             ppu_get_context()->current_frame++;
-
-            // FPS calculation and timing
-            u32 end = get_ticks();
-            u32 frame_time = end - prev_frame_time;
-
-            if (frame_time < target_frame_time){
-                delay((target_frame_time - frame_time));
-            }
-
-            if (end - start_timer >= 1000) {
-                u32 fps = frame_count;
-                start_timer = end;
-                frame_count = 0;
-
-                printf("FPS: %d\n", fps);
-
-                // This block runs every second thus we can check if we need to save the cart
-                if (cart_need_save()){cart_battery_save();}
-            }
-
-            frame_count++;
-            prev_frame_time = get_ticks();
+            ppu_frame_publish();
 
         } else {
             LCDS_MODE_SET(MODE_OAM);
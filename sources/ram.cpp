@@ -1,13 +1,8 @@
 #include <../headers/ram.hpp>
+#include <../headers/cpu_cache.hpp>
+#include <../headers/gameboy.hpp>
 
 
-typedef struct {
-    u8 wram[0x2000];
-    u8 hram[0x80];
-} ram_context;
-
-static ram_context ctx;
-
 u8 wram_read(u16 address) {
     address -= 0xC000;
 
@@ -16,23 +11,25 @@ u8 wram_read(u16 address) {
         exit(-1);
     }
 
-    return ctx.wram[address];
+    return gb->ram.wram[address];
 }
 
 void wram_write(u16 address, u8 value) {
+    cpu_cache_invalidate(address);
     address -= 0xC000;
 
-    ctx.wram[address] = value;
+    gb->ram.wram[address] = value;
 }
 
 u8 hram_read(u16 address) {
     address -= 0xFF80;
 
-    return ctx.hram[address];
+    return gb->ram.hram[address];
 }
 
 void hram_write(u16 address, u8 value) {
+    cpu_cache_invalidate(address);
     address -= 0xFF80;
 
-    ctx.hram[address] = value;
+    gb->ram.hram[address] = value;
 }
@@ -0,0 +1,163 @@
+#include <./../headers/scheduler.hpp>
+#include <./../headers/timer.hpp>
+#include <./../headers/ppu.hpp>
+#include <./../headers/dma.hpp>
+#include <./../headers/gameboy.hpp>
+#include <string.h>
+
+// Binary min-heap on the event time, `pos` finds an event in it so a repost
+// moves the entry instead of adding a second one
+
+// Posts the component's next event, indexed by sched_event
+static void (*const schedulers[SCHED_EVENT_COUNT])() = {
+    timer_schedule,     // SCHED_TIMER
+    ppu_schedule,       // SCHED_PPU
+    dma_schedule        // SCHED_DMA
+};
+
+static void sched_swap(u32 a, u32 b) {
+    sched_entry t = gb->sched.heap[a];
+
+    gb->sched.heap[a] = gb->sched.heap[b];
+    gb->sched.heap[b] = t;
+
+    gb->sched.pos[gb->sched.heap[a].ev] = a;
+    gb->sched.pos[gb->sched.heap[b].ev] = b;
+}
+
+static void sched_sift_up(u32 i) {
+    while (i && gb->sched.heap[i].when < gb->sched.heap[(i - 1) / 2].when) {
+        sched_swap(i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void sched_sift_down(u32 i) {
+    while (true) {
+        u32 min = i;
+        u32 l = 2 * i + 1;
+        u32 r = l + 1;
+
+        if (l < gb->sched.size && gb->sched.heap[l].when < gb->sched.heap[min].when) {
+            min = l;
+        }
+
+        if (r < gb->sched.size && gb->sched.heap[r].when < gb->sched.heap[min].when) {
+            min = r;
+        }
+
+        if (min == i) {
+            return;
+        }
+
+        sched_swap(i, min);
+        i = min;
+    }
+}
+
+void sched_init() {
+    u64 now = gb->sched.now;
+
+    memset(&gb->sched, 0, sizeof(gb->sched));
+    gb->sched.now = now;
+
+    for (int i = 0; i < SCHED_EVENT_COUNT; i++) {
+        gb->sched.pos[i] = -1;
+    }
+
+    sched_post_all();
+}
+
+u64 sched_now() {
+    return gb->sched.now;
+}
+
+void sched_advance(u32 ticks) {
+    gb->sched.now += ticks;
+}
+
+void sched_post(sched_event ev, u32 idle_ticks) {
+    int i = gb->sched.pos[ev];
+
+    if (i < 0) {
+        i = gb->sched.size++;
+        gb->sched.pos[ev] = i;
+        gb->sched.heap[i].ev = ev;
+
+        if (gb->sched.size > gb->sched.stats.max_depth) {
+            gb->sched.stats.max_depth = gb->sched.size;
+        }
+    }
+
+    gb->sched.heap[i].when = gb->sched.now + idle_ticks;
+    gb->sched.stats.posted[ev]++;
+
+    sched_sift_up(i);
+    sched_sift_down(gb->sched.pos[ev]);
+}
+
+void sched_cancel(sched_event ev) {
+    int i = gb->sched.pos[ev];
+
+    if (i < 0) {
+        return;
+    }
+
+    gb->sched.size--;
+
+    if ((u32)i != gb->sched.size) {
+        sched_swap(i, gb->sched.size);
+        sched_sift_up(i);
+        sched_sift_down(gb->sched.pos[gb->sched.heap[i].ev]);
+    }
+
+    gb->sched.pos[ev] = -1;
+}
+
+void sched_post_all() {
+    for (int i = 0; i < SCHED_EVENT_COUNT; i++) {
+        schedulers[i]();
+    }
+}
+
+void sched_dispatch() {
+    while (gb->sched.size && gb->sched.heap[0].when < gb->sched.now) {
+        sched_event ev = gb->sched.heap[0].ev;
+
+        sched_cancel(ev);
+        gb->sched.stats.fired[ev]++;
+
+        schedulers[ev]();
+    }
+}
+
+u32 sched_idle_ticks() {
+    if (!gb->sched.size) {
+        return UINT32_MAX;
+    }
+
+    u64 idle = gb->sched.heap[0].when - gb->sched.now;
+
+    return idle < UINT32_MAX ? idle : UINT32_MAX;
+}
+
+u32 sched_depth() {
+    return gb->sched.size;
+}
+
+const sched_stats *sched_get_stats() {
+    return &gb->sched.stats;
+}
+
+void sched_print_stats() {
+    static const char *names[SCHED_EVENT_COUNT] = {"timer", "ppu", "dma"};
+
+    printf("Scheduler: depth %u (max %u)", gb->sched.size, gb->sched.stats.max_depth);
+
+    for (int i = 0; i < SCHED_EVENT_COUNT; i++) {
+        printf(", %s %llu fired/%llu posted", names[i],
+            (unsigned long long)gb->sched.stats.fired[i], (unsigned long long)gb->sched.stats.posted[i]);
+    }
+
+    printf("\n");
+}
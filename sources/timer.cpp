@@ -1,84 +1,137 @@
 #include <./../headers/timer.hpp>
 #include <./../headers/interrupts.hpp>
+#include <./../headers/scheduler.hpp>
+#include <./../headers/gameboy.hpp>
+#include <string.h>
 
-static timer_context ctx = {0};
+// DIV and TIMA aren't ticked: gb->timer holds them as of the scheduler tick `base`
+// and timer_update() works out what the T-cycles since then did to them.
+// The TIMA overflow is the only thing with a side effect, so it's the one
+// scheduled event.
 
-timer_context *timer_get_context() {
-    return &ctx;
+// TIMA counts falling edges of one DIV bit, i.e. every `period` T-cycles
+static u32 timer_period() {
+    static const u32 periods[4] = {1024, 16, 64, 256};
+
+    return periods[gb->timer.tac & 0b11];
 }
 
-void timer_init() {
-    ctx.div = 0xAC00;
+// TIMA increments left until it reloads, which happens once it reaches 0xFF
+static u32 timer_increments() {
+    u32 increments = (u8)(0xFF - gb->timer.tima);
+
+    return increments ? increments : 0x100;
 }
 
-void timer_tick() {
-    u16 prev_div = ctx.div;
+// Brings DIV and TIMA up to the scheduler clock
+static void timer_update() {
+    u64 now = sched_now();
+    u64 ticks = now - gb->timer.base;
 
-    ctx.div++;
+    gb->timer.base = now;
 
-    bool timer_update = false;
+    if (gb->timer.tac & (1 << 2)) {
+        u32 period = timer_period();
 
-    switch(ctx.tac & (0b11)) {
-        case 0b00:
-            timer_update = (prev_div & (1 << 9)) && (!(ctx.div & (1 << 9)));
-            break;
-        case 0b01:
-            timer_update = (prev_div & (1 << 3)) && (!(ctx.div & (1 << 3)));
-            break;
-        case 0b10:
-            timer_update = (prev_div & (1 << 5)) && (!(ctx.div & (1 << 5)));
-            break;
-        case 0b11:
-            timer_update = (prev_div & (1 << 7)) && (!(ctx.div & (1 << 7)));
-            break;
-    }
+        // DIV wraps on a multiple of every period, so the edge count holds across it
+        u64 edges = ((gb->timer.div + ticks) / period) - (gb->timer.div / period);
+
+        while (edges) {
+            u32 increments = timer_increments();
 
-    if (timer_update && ctx.tac & (1 << 2)) {
-        ctx.tima++;
+            if (edges < increments) {
+                gb->timer.tima += edges;
+                break;
+            }
 
-        if (ctx.tima == 0xFF) {
-            ctx.tima = ctx.tma;
+            edges -= increments;
+            gb->timer.tima = gb->timer.tma;
 
             cpu_request_interrupt(IT_TIMER);
         }
     }
+
+    gb->timer.div += ticks;
+}
+
+timer_context *timer_get_context() {
+    timer_update();
+    return &gb->timer;
+}
+
+void timer_init() {
+    memset(&gb->timer, 0, sizeof(gb->timer));
+    gb->timer.base = sched_now();
+    gb->timer.div = 0xAC00;
+}
+
+u32 timer_idle_ticks() {
+    if (!(gb->timer.tac & (1 << 2))) {
+        return UINT32_MAX;
+    }
+
+    u32 period = timer_period();
+    u32 first = period - (gb->timer.div & (period - 1));
+
+    return first + (timer_increments() - 1) * period - 1;
+}
+
+void timer_schedule() {
+    // Also the overflow event itself: reloads TIMA and raises the interrupt
+    timer_update();
+
+    u32 idle = timer_idle_ticks();
+
+    if (idle == UINT32_MAX) {
+        // Stopped, only a TAC write starts it again
+        sched_cancel(SCHED_TIMER);
+    } else {
+        sched_post(SCHED_TIMER, idle);
+    }
 }
 
 void timer_write(u16 address, u8 value) {
+    timer_update();
+
     switch(address) {
         case 0xFF04:
             //DIV
-            ctx.div = 0;
+            gb->timer.div = 0;
             break;
 
         case 0xFF05:
             //TIMA
-            ctx.tima = value;
+            gb->timer.tima = value;
             break;
 
         case 0xFF06:
             //TMA
-            ctx.tma = value;
+            gb->timer.tma = value;
             break;
 
         case 0xFF07:
             //TAC
-            ctx.tac = value;
+            gb->timer.tac = value;
             break;
     }
+
+    // The overflow moves with any of them
+    timer_schedule();
 }
 
 u8 timer_read(u16 address) {
+    timer_update();
+
     switch(address) {
         case 0xFF04:
-            return ctx.div >> 8;
+            return gb->timer.div >> 8;
         case 0xFF05:
-            return ctx.tima;
+            return gb->timer.tima;
         case 0xFF06:
-            return ctx.tma;
+            return gb->timer.tma;
         case 0xFF07:
-            return ctx.tac;
+            return gb->timer.tac;
     }
     // Invalid address
     return 0xFF;
-}
\ No newline at end of file
+}
@@ -11,6 +11,7 @@
 #include <SDL2/SDL_image.h>
 
 #include <dirent.h>
+#include <atomic>
 #include <algorithm>
 #include <vector>
 #include <string>
@@ -23,6 +24,18 @@ SDL_Surface *screen;
 
 static SDL_Texture* bgTexture = nullptr;
 
+// SDL user event pushed by ui_frame_ready(), at most one sits in the queue
+static Uint32 frame_event = (Uint32)-1;
+static std::atomic<bool> frame_pending(false);
+
+static void ui_frame_ready(void *);
+
+typedef struct {
+    bool paused;                // What the control keys last asked for
+} ui_context;
+
+static ui_context ctx = {false};
+
 #define GB_WIDTH 160
 #define GB_HEIGHT 144
 
@@ -165,6 +178,10 @@ void ui_init(std::string g_rom_path) {
         exit(1);
     }
     printf("[ui_init] Texture OK\n");
+
+    frame_event = SDL_RegisterEvents(1);
+    emu_set_frame_callback(ui_frame_ready, NULL);
+
     // --- Use ROM filename for background ---
     std::string bg_file;
 
@@ -213,7 +230,7 @@ void ui_update() {
     int win_w, win_h;
     SDL_GetWindowSize(sdlWindow, &win_w, &win_h);
 
-    u32 *video_buffer = ppu_get_context()->video_buffer;
+    const u32 *video_buffer = ppu_frame_acquire();
 
     for (int line_num = 0; line_num < GB_HEIGHT; line_num++) {
         for (int x = 0; x < GB_WIDTH; x++) {
@@ -240,6 +257,24 @@ void ui_update() {
     SDL_RenderPresent(sdlRenderer);
 }
 
+// P pauses and resumes, F steps a frame and S an instruction (both pause)
+static void ui_on_control_key(u32 key_code){
+    switch (key_code){
+        case SDLK_p:
+            ctx.paused = !ctx.paused;
+            emu_command_post(ctx.paused ? EMU_CMD_PAUSE : EMU_CMD_RUN);
+            break;
+        case SDLK_f:
+            ctx.paused = true;
+            emu_command_post(EMU_CMD_STEP_FRAME);
+            break;
+        case SDLK_s:
+            ctx.paused = true;
+            emu_command_post(EMU_CMD_STEP);
+            break;
+    }
+}
+
 void ui_on_key(bool down, u32 key_code){
     switch (key_code){
         case SDLK_z:      gamepad_get_state()->a = down; break;
@@ -255,18 +290,57 @@ void ui_on_key(bool down, u32 key_code){
     }
 }
 
-void ui_handle_events() {
+// Frame callback, runs on the emulation thread
+static void ui_frame_ready(void *) {
+    // The UI shows the newest frame anyway, so one pending wake-up is enough
+    if (frame_event == (Uint32)-1 || frame_pending.exchange(true)) {
+        return;
+    }
+
     SDL_Event e;
-    while (SDL_PollEvent(&e) > 0) {
-        if (e.type == SDL_KEYDOWN){
-            ui_on_key(true, e.key.keysym.sym);
-        }
-        if (e.type == SDL_KEYUP){
-            ui_on_key(false, e.key.keysym.sym);
+    SDL_zero(e);
+    e.type = frame_event;
+    SDL_PushEvent(&e);
+}
+
+static void ui_handle_event(SDL_Event *e) {
+    if (e->type == SDL_KEYDOWN){
+        // A held key repeats, the controls act once per press
+        if (!e->key.repeat){
+            ui_on_control_key(e->key.keysym.sym);
         }
-        if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_CLOSE) {
-            emu_get_context()->die = true;
+
+        ui_on_key(true, e->key.keysym.sym);
+    }
+    if (e->type == SDL_KEYUP){
+        ui_on_key(false, e->key.keysym.sym);
+    }
+    if (e->type == SDL_WINDOWEVENT && e->window.event == SDL_WINDOWEVENT_CLOSE) {
+        emu_get_context()->die = true;
+    }
+}
+
+void ui_wait_events() {
+    SDL_Event e;
+    bool new_frame = false;
+
+    if (!SDL_WaitEvent(&e)) {
+        return;
+    }
+
+    // Drain whatever else queued up, then draw once
+    do {
+        if (e.type == frame_event) {
+            new_frame = true;
+        } else {
+            ui_handle_event(&e);
         }
+    } while (SDL_PollEvent(&e) > 0);
+
+    if (new_frame) {
+        // Cleared first, a frame published while drawing wakes us again
+        frame_pending = false;
+        ui_update();
     }
 }
 static std::vector<std::string> list_roms(const std::string &directory) {
@@ -0,0 +1,112 @@
+#include <stdio.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "reuse_roms.hpp"
+
+// Runs emu_batch on one worker over A, B, A, B (see reuse_roms.hpp), so
+// every B but the first job the worker takes runs on the instance A just
+// left. Each B has to send the serial output and get the hash it gets on a
+// fresh instance, whatever the job order.
+//
+//   batch_test <emu_batch>
+
+#define BATCH_MANIFEST "reuse_batch.txt"
+#define BATCH_FRAMES 4
+
+// Value of "key":"..." in a result line, empty if missing
+static std::string json_field(const char *line, const char *key) {
+    std::string pattern = std::string("\"") + key + "\":\"";
+    const char *p = strstr(line, pattern.c_str());
+
+    if (!p) {
+        return "";
+    }
+
+    p += pattern.size();
+    const char *end = strchr(p, '"');
+
+    return end ? std::string(p, end - p) : "";
+}
+
+static bool check_core(const char *batch, const char *core) {
+    std::string cmd = std::string("\"") + batch + "\" " BATCH_MANIFEST " -j 1 --core " + core + " 2>/dev/null";
+    FILE *fp = popen(cmd.c_str(), "r");
+
+    if (!fp) {
+        printf("%s: failed to run %s\n", core, batch);
+        return false;
+    }
+
+    char line[4096];
+    std::vector<std::string> hashes;
+    bool ok = true;
+
+    while (fgets(line, sizeof(line), fp)) {
+        if (json_field(line, "rom") != REUSE_ROM_B) {
+            continue;
+        }
+
+        std::string serial = json_field(line, "serial");
+        std::string hash = json_field(line, "hash");
+
+        if (serial != REUSE_SERIAL_B) {
+            printf("%s: %s sent \"%s\", expected \"%s\"\n", core, REUSE_ROM_B, serial.c_str(), REUSE_SERIAL_B);
+            ok = false;
+        }
+
+        hashes.push_back(hash);
+    }
+
+    if (pclose(fp)) {
+        printf("%s: emu_batch failed\n", core);
+        ok = false;
+    }
+
+    if (hashes.size() != 2) {
+        printf("%s: %zu results for %s, expected 2\n", core, hashes.size(), REUSE_ROM_B);
+        return false;
+    }
+
+    if (hashes[0] != hashes[1]) {
+        printf("%s: %s hashes differ between runs: %s %s\n", core, REUSE_ROM_B, hashes[0].c_str(), hashes[1].c_str());
+        ok = false;
+    }
+
+    return ok;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printf("Usage: %s <emu_batch>\n", argv[0]);
+        return 1;
+    }
+
+    if (!reuse_write_roms()) {
+        return 1;
+    }
+
+    FILE *fp = fopen(BATCH_MANIFEST, "w");
+    if (!fp) {
+        printf("Failed to write %s\n", BATCH_MANIFEST);
+        return 1;
+    }
+
+    for (int i = 0; i < 2; i++) {
+        fprintf(fp, "%s %d\n%s %d\n", REUSE_ROM_A, BATCH_FRAMES, REUSE_ROM_B, BATCH_FRAMES);
+    }
+
+    fclose(fp);
+
+    bool ok = check_core(argv[1], "interp") &&
+              check_core(argv[1], "threaded") &&
+              check_core(argv[1], "dynarec");
+
+    if (ok) {
+        printf("Batch: a ROM run after another on one worker matches its fresh run on every core\n");
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdio.h>
+#include <string.h>
+
+#include "../headers/common.hpp"
+
+// Two MBC1 carts (64 KB, 8 KB RAM) for running one instance on a ROM after
+// another one:
+//
+//   reuse_a.gb  enables the cart RAM, writes to it, selects ROM bank 2, spins
+//   reuse_b.gb  sends 'D' over serial if the cart RAM reads as disabled ('E'
+//               otherwise), then calls 0x4000 under ROM bank 1 and bank 2,
+//               which send their bank number: "D12" from a clean cart
+//
+// ROM B's first call would run bank 1 code cached as bank 2 if the bank
+// register of ROM A was left over, and print "D11".
+
+#define REUSE_ROM_A "reuse_a.gb"
+#define REUSE_ROM_B "reuse_b.gb"
+#define REUSE_SERIAL_B "D12"
+
+#define REUSE_ROM_SIZE 0x10000
+#define REUSE_SERIAL_OUT 0x0200
+
+static u8 reuse_rom[REUSE_ROM_SIZE];
+
+static void reuse_put(u32 at, const u8 *bytes, u32 n) {
+    memcpy(reuse_rom + at, bytes, n);
+}
+
+static bool reuse_write_rom(const char *path, bool b) {
+    memset(reuse_rom, 0, sizeof(reuse_rom));
+
+    // NOP; JP 0x0150, then the header: MBC1, 64 KB, 8 KB RAM
+    const u8 entry[] = {0x00, 0xC3, 0x50, 0x01};
+    reuse_put(0x100, entry, sizeof(entry));
+    memcpy(reuse_rom + 0x134, b ? "REUSE B" : "REUSE A", 7);
+    reuse_rom[0x147] = 0x01;
+    reuse_rom[0x148] = 0x01;
+    reuse_rom[0x149] = 0x02;
+
+    // LDH (01),A; LD A,81; LDH (02),A; RET
+    const u8 serial_out[] = {0xE0, 0x01, 0x3E, 0x81, 0xE0, 0x02, 0xC9};
+    reuse_put(REUSE_SERIAL_OUT, serial_out, sizeof(serial_out));
+
+    // Every switchable bank: LD A,'0'+bank; CALL serial_out; RET
+    for (u32 bank = 1; bank < 4; bank++) {
+        const u8 code[] = {0x3E, (u8)('0' + bank), 0xCD, REUSE_SERIAL_OUT & 0xFF, REUSE_SERIAL_OUT >> 8, 0xC9};
+        reuse_put(bank * 0x4000, code, sizeof(code));
+    }
+
+    if (!b) {
+        const u8 code[] = {
+            0x3E, 0x0A, 0xEA, 0x00, 0x00,       // LD A,0A; LD (0000),A     RAM on
+            0x3E, 0x41, 0xEA, 0x00, 0xA0,       // LD A,41; LD (A000),A
+            0x3E, 0x02, 0xEA, 0x00, 0x20,       // LD A,02; LD (2000),A     bank 2
+            0x18, 0xFE                          // JR -2
+        };
+
+        reuse_put(0x150, code, sizeof(code));
+    } else {
+        const u8 code[] = {
+            0x31, 0xFE, 0xFF,                   // LD SP,FFFE
+            0xFA, 0x00, 0xA0,                   // LD A,(A000)
+            0x3C,                               // INC A, zero if it read FF
+            0x3E, 'D',                          // LD A,'D'
+            0x28, 0x02,                         // JR Z,+2
+            0x3E, 'E',                          // LD A,'E'
+            0xCD, REUSE_SERIAL_OUT & 0xFF, REUSE_SERIAL_OUT >> 8,
+            0xCD, 0x00, 0x40,                   // CALL 4000
+            0x3E, 0x02, 0xEA, 0x00, 0x20,       // LD A,02; LD (2000),A
+            0xCD, 0x00, 0x40,                   // CALL 4000
+            0x18, 0xFE                          // JR -2
+        };
+
+        reuse_put(0x150, code, sizeof(code));
+    }
+
+    FILE *fp = fopen(path, "wb");
+    if (!fp) {
+        printf("Failed to write %s\n", path);
+        return false;
+    }
+
+    bool ok = fwrite(reuse_rom, sizeof(reuse_rom), 1, fp) == 1;
+    fclose(fp);
+
+    return ok;
+}
+
+// Both carts into the working directory
+static bool reuse_write_roms() {
+    return reuse_write_rom(REUSE_ROM_A, false) && reuse_write_rom(REUSE_ROM_B, true);
+}
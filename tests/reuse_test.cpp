@@ -0,0 +1,89 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../headers/main.hpp"
+#include "../headers/cart.hpp"
+#include "../headers/cpu.hpp"
+#include "../headers/cpu_idle.hpp"
+#include "../headers/dbg.hpp"
+#include "../headers/ppu.hpp"
+#include "../headers/gameboy.hpp"
+#include "reuse_roms.hpp"
+
+// Loads a cart on an instance that already ran another one (the way
+// emu_batch reuses them) and checks that nothing of the first cart is left:
+// the MBC registers, the serial output, the idle loop table and that the
+// second ROM sends what it sends on a fresh instance, on every core.
+
+#define TEST_FRAMES 4
+
+static bool run_rom(const char *rom) {
+    if (!cart_load((char *)rom)) {
+        return false;
+    }
+
+    emu_init();
+
+    while (ppu_get_context()->current_frame < TEST_FRAMES) {
+        if (!cpu_exec(CPU_EXEC_BATCH)) {
+            break;
+        }
+    }
+
+    return true;
+}
+
+static bool check_core(cpu_core core, const char *name) {
+    gameboy *instance = gb_create();
+    gb_bind(instance);
+    cpu_set_core(core);
+
+    // What cart_load() and emu_init() have to reset before the next ROM runs
+    bool ok = run_rom(REUSE_ROM_A) && cart_load((char *)REUSE_ROM_B);
+
+    if (ok) {
+        emu_init();
+    }
+
+    cart_context *cart = cart_get_context();
+    const cpu_idle_stats *idle = cpu_idle_get_stats();
+
+    if (ok && (cart->rom_bank_value != 1 || cart->ram_enabled || cart->ram_banking ||
+            cart->banking_mode || cart->ram_bank_value || cart->rom_bank_x != cart->rom_data + 0x4000)) {
+        printf("%s: MBC state of the previous cart left over (ROM bank %u, RAM %s, mode %u, RAM bank %u)\n",
+            name, cart->rom_bank_value, cart->ram_enabled ? "enabled" : "disabled",
+            cart->banking_mode, cart->ram_bank_value);
+        ok = false;
+    }
+
+    if (ok && (dbg_get_serial_size() || idle->loops || idle->skips)) {
+        printf("%s: serial output or idle loops of the previous cart left over\n", name);
+        ok = false;
+    }
+
+    ok = ok && run_rom(REUSE_ROM_B);
+
+    if (ok && strcmp(dbg_get_serial(), REUSE_SERIAL_B)) {
+        printf("%s: second ROM sent \"%s\", expected \"%s\"\n", name, dbg_get_serial(), REUSE_SERIAL_B);
+        ok = false;
+    }
+
+    gb_destroy(instance);
+    return ok;
+}
+
+int main() {
+    if (!reuse_write_roms()) {
+        return 1;
+    }
+
+    bool ok = check_core(CORE_INTERP, "interp") &&
+              check_core(CORE_THREADED, "threaded") &&
+              check_core(CORE_DYNAREC, "dynarec");
+
+    if (ok) {
+        printf("Reuse: a cart loaded after another runs like on a fresh instance on every core\n");
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "../headers/main.hpp"
+#include "../headers/cart.hpp"
+#include "../headers/cpu.hpp"
+#include "../headers/cpu_idle.hpp"
+#include "../headers/ppu.hpp"
+#include "../headers/lcd.hpp"
+#include "../headers/gameboy.hpp"
+
+// Runs the same ROM on two instances, one drawing mode 3 with the scanline
+// renderer and one with the FIFO only, and checks after every instruction
+// that both are in the same state: CPU registers, clock, LY, STAT, the dot
+// and, outside mode 3, the FIFO and the pixels of the current line.
+//
+// The ROM writes STAT in mode 3 of every fourth line (mode bits 0), which
+// sends the scanline instance to the FIFO for the rest of the line and must
+// neither end mode 3 early nor leave pixels in the FIFO for the next one.
+
+#define TEST_ROM "scanline_stat.gb"
+#define TEST_ROM_SIZE 0x8000
+#define TEST_FRAMES 8
+
+static u8 test_rom[TEST_ROM_SIZE];
+
+static bool write_rom() {
+    // NOP; JP 0x0150, then the header: no MBC, 32 KB
+    const u8 entry[] = {0x00, 0xC3, 0x50, 0x01};
+    memcpy(test_rom + 0x100, entry, sizeof(entry));
+    memcpy(test_rom + 0x134, "SCANLINE", 8);
+
+    const u8 code[] = {
+        0x31, 0xFE, 0xFF,                   // LD SP,FFFE
+        0x21, 0x00, 0x80,                   // LD HL,8000
+        0x06, 0x10,                         // LD B,16
+        0x7D, 0x22, 0x05, 0x20, 0xFC,       // LD A,L; LDI (HL),A; DEC B; JR NZ   tile 0
+        0x3E, 0x03, 0xE0, 0x43,             // LD A,03; LDH (43),A                SCX
+        0x3E, 0xB1, 0xE0, 0x40,             // LD A,B1; LDH (40),A                LCDC
+        // loop:
+        0xF0, 0x41, 0xE6, 0x03,             // LDH A,(41); AND 3
+        0xFE, 0x03, 0x20, 0xF8,             // CP 3; JR NZ,loop                   mode 3
+        0xF0, 0x44, 0xE6, 0x03,             // LDH A,(44); AND 3
+        0xFE, 0x01, 0x20, 0x04,             // CP 1; JR NZ,wait                   LY % 4 == 1
+        0x3E, 0x48, 0xE0, 0x41,             // LD A,48; LDH (41),A
+        // wait:
+        0xF0, 0x41, 0xE6, 0x03,             // LDH A,(41); AND 3
+        0xFE, 0x03, 0x28, 0xF8,             // CP 3; JR Z,wait                    end of mode 3
+        0x18, 0xE2                          // JR loop
+    };
+
+    memcpy(test_rom + 0x150, code, sizeof(code));
+
+    FILE *fp = fopen(TEST_ROM, "wb");
+    if (!fp) {
+        printf("Failed to write %s\n", TEST_ROM);
+        return false;
+    }
+
+    bool ok = fwrite(test_rom, sizeof(test_rom), 1, fp) == 1;
+    fclose(fp);
+
+    return ok;
+}
+
+static gameboy *start(bool scanline) {
+    gameboy *instance = gb_create();
+    gb_bind(instance);
+    ppu_line_set_enabled(scanline);
+
+    // An idle loop skip is one step, compare per instruction
+    cpu_idle_set_enabled(false);
+
+    if (!cart_load((char *)TEST_ROM)) {
+        gb_destroy(instance);
+        return nullptr;
+    }
+
+    emu_init();
+    return instance;
+}
+
+// Both instances after the same number of steps, false on the first difference
+static bool compare(const gameboy *s, const gameboy *f, u64 step) {
+    const char *what = nullptr;
+    lcd_mode mode = (lcd_mode)(s->lcd.lcds & 0b11);
+
+    if (memcmp(&s->cpu.regs, &f->cpu.regs, sizeof(s->cpu.regs)) ||
+            memcmp(&s->cpu.lazy, &f->cpu.lazy, sizeof(s->cpu.lazy))) {
+        what = "CPU registers";
+    } else if (s->emu.ticks != f->emu.ticks) {
+        what = "clock";
+    } else if (s->lcd.ly != f->lcd.ly || s->lcd.lcds != f->lcd.lcds) {
+        what = "LY or STAT";
+    } else if (s->ppu.line_ticks != f->ppu.line_ticks) {
+        what = "dot";
+    } else if (mode != MODE_TRANSFER) {
+        // The scanline renderer draws mode 3 all at once, compare after it
+        if (s->ppu.pfc.pushed_x != f->ppu.pfc.pushed_x ||
+                s->ppu.pfc.pixel_fifo.size != f->ppu.pfc.pixel_fifo.size) {
+            what = "FIFO";
+        } else if (s->lcd.ly < YRES && memcmp(s->ppu.video_buffer + s->lcd.ly * XRES,
+                f->ppu.video_buffer + f->lcd.ly * XRES, XRES * sizeof(u32))) {
+            what = "pixels";
+        }
+    }
+
+    if (what) {
+        printf("Step %llu, LY %u: %s differ between the scanline renderer and the FIFO\n",
+            (unsigned long long)step, s->lcd.ly, what);
+        return false;
+    }
+
+    return true;
+}
+
+int main() {
+    if (!write_rom()) {
+        return 1;
+    }
+
+    gameboy *fifo = start(false);
+    gameboy *scanline = start(true);
+
+    if (!fifo || !scanline) {
+        return 1;
+    }
+
+    bool ok = true;
+    u64 step = 0;
+
+    while (ok && scanline->ppu.current_frame < TEST_FRAMES) {
+        gb_bind(scanline);
+        ok = cpu_exec(1);
+
+        gb_bind(fifo);
+        ok = ok && cpu_exec(1);
+
+        ok = ok && compare(scanline, fifo, ++step);
+    }
+
+    if (ok && !scanline->ppu.line_stats.scanline) {
+        printf("No line was drawn by the scanline renderer\n");
+        ok = false;
+    }
+
+    if (ok) {
+        printf("Scanline: %llu steps in lockstep with the FIFO, %llu lines drawn by the renderer\n",
+            (unsigned long long)step, (unsigned long long)scanline->ppu.line_stats.scanline);
+    }
+
+    gb_destroy(scanline);
+    gb_destroy(fifo);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,175 @@
+#include <stdio.h>
+
+#include "../headers/main.hpp"
+#include "../headers/bus.hpp"
+#include "../headers/timer.hpp"
+#include "../headers/interrupts.hpp"
+#include "../headers/gameboy.hpp"
+
+// Runs the lazy timer (timer.cpp, driven by the scheduler through the bus
+// and emu_cycles() like the CPU does) next to the per-tick timer it
+// replaced, with the same register writes landing mid-period, and checks
+// DIV, TIMA and the IF timer bit after every step.
+
+#define TEST_STEPS 2000000
+
+// The per-tick timer: DIV counts every T-cycle and TIMA every falling edge
+// of the DIV bit TAC selects, reloading from TMA once it reaches 0xFF
+typedef struct {
+    u16 div;
+    u8 tima;
+    u8 tma;
+    u8 tac;
+    u8 int_flags;
+    u64 overflows;
+} tick_timer;
+
+static void tick_timer_tick(tick_timer *t) {
+    static const u8 bits[4] = {9, 3, 5, 7};
+    u16 prev_div = t->div;
+    u8 bit = bits[t->tac & 0b11];
+
+    t->div++;
+
+    bool edge = (prev_div & (1 << bit)) && !(t->div & (1 << bit));
+
+    if (edge && (t->tac & (1 << 2))) {
+        t->tima++;
+
+        if (t->tima == 0xFF) {
+            t->tima = t->tma;
+            t->int_flags |= IT_TIMER;
+            t->overflows++;
+        }
+    }
+}
+
+static void tick_timer_write(tick_timer *t, u16 address, u8 value) {
+    switch (address) {
+        case 0xFF04: t->div = 0; break;
+        case 0xFF05: t->tima = value; break;
+        case 0xFF06: t->tma = value; break;
+        case 0xFF07: t->tac = value; break;
+        case 0xFF0F: t->int_flags = value & IT_TIMER; break;
+    }
+}
+
+// Both timers get the same write
+static void write(tick_timer *t, u16 address, u8 value) {
+    bus_write(address, value);
+    tick_timer_write(t, address, value);
+}
+
+// xorshift32, the same sequence on every run
+static u32 rng_state = 0x12345678;
+
+static u32 rng() {
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+
+    return rng_state;
+}
+
+// Register writes between steps: mostly none, so periods run out, and
+// every kind of write when they happen
+static void random_writes(tick_timer *t) {
+    u32 r = rng();
+
+    if (r % 64) {
+        return;
+    }
+
+    r >>= 6;
+
+    switch (r % 8) {
+        case 0:
+            write(t, 0xFF04, 0);
+            break;
+        case 1:
+            write(t, 0xFF05, rng());
+            break;
+        case 2:
+            // Close to the overflow
+            write(t, 0xFF05, 0xF8 + (rng() % 8));
+            break;
+        case 3:
+            write(t, 0xFF06, rng());
+            break;
+        case 4:
+            // Frequency change, the timer keeps running
+            write(t, 0xFF07, 0b100 | (rng() % 4));
+            break;
+        case 5:
+            // Any value, including stopping it
+            write(t, 0xFF07, rng());
+            break;
+        case 6:
+            // Acknowledged, so later overflows show up again
+            write(t, 0xFF0F, 0);
+            break;
+        case 7:
+            // Restarted right before an overflow at the fastest rate
+            write(t, 0xFF07, 0b101);
+            write(t, 0xFF05, 0xFE);
+            break;
+    }
+}
+
+static bool check(const tick_timer *t, u32 step) {
+    u8 div = bus_read(0xFF04);
+    u8 tima = bus_read(0xFF05);
+    // The other IF bits are the PPU's, it runs even with the LCD off
+    u8 int_flags = bus_read(0xFF0F) & IT_TIMER;
+
+    if (div == (t->div >> 8) && tima == t->tima && int_flags == t->int_flags) {
+        return true;
+    }
+
+    printf("Mismatch at step %u (TAC %02X TMA %02X): DIV %02X/%02X TIMA %02X/%02X IF %02X/%02X (lazy/per-tick)\n",
+        step, t->tac, t->tma, div, t->div >> 8, tima, t->tima, int_flags, t->int_flags);
+
+    return false;
+}
+
+int main() {
+    gameboy *instance = gb_create();
+    gb_bind(instance);
+
+    emu_init();
+
+    bus_write(0xFF0F, 0);
+
+    tick_timer t = {};
+    timer_context *lazy = timer_get_context();
+    t.div = lazy->div;
+    t.tima = lazy->tima;
+    t.tma = lazy->tma;
+    t.tac = lazy->tac;
+
+    write(&t, 0xFF07, 0b101);
+
+    for (u32 step = 0; step < TEST_STEPS; step++) {
+        random_writes(&t);
+
+        // 1 - 6 M-cycles, like an instruction
+        u32 cycles = 1 + (rng() % 6);
+
+        emu_cycles(cycles);
+
+        for (u32 n = 0; n < cycles * 4; n++) {
+            tick_timer_tick(&t);
+        }
+
+        if (!check(&t, step)) {
+            gb_destroy(instance);
+            return 1;
+        }
+    }
+
+    printf("Timer: %u steps, %llu overflows, lazy and per-tick timers agree\n",
+        TEST_STEPS, (unsigned long long)t.overflows);
+
+    gb_destroy(instance);
+    return 0;
+}